@@ -0,0 +1,60 @@
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+#include "solver/delta_blue.h"
+#include "solver/quick_plan.h"
+
+namespace NPropertyModels::NBenchmarks {
+
+namespace {
+
+using NSolver::TTask;
+
+// a chain of two-way equalities, the stay of the edited end is the
+// strongest one, as when dragging a slider bound to either end
+TTask MakeChainTask(size_t length, bool editedFirst) {
+	TTask task{
+	    .PropertiesCount = length + 1,
+	    .ConstraintsCount = 2 * length + 1,
+	    .CSMs{},
+	};
+	for (size_t id = 0; id < length; ++id) {
+		task.CSMs.push_back({.ConstraintId = id, .InputPropertyIds = {id}, .OutputPropertyIds = {id + 1}});
+		task.CSMs.push_back({.ConstraintId = id, .InputPropertyIds = {id + 1}, .OutputPropertyIds = {id}});
+	}
+	for (size_t stayId = 0; stayId <= length; ++stayId) {
+		size_t propertyId = editedFirst ? stayId : length - stayId;
+		task.CSMs.push_back({.ConstraintId = length + stayId, .InputPropertyIds = {}, .OutputPropertyIds = {propertyId}});
+	}
+	return task;
+}
+
+TEST_CASE("delta blue on repeated edits", "[!benchmark][delta_blue]") {
+	const size_t length = GENERATE(1'000, 10'000);
+
+	const TTask task = MakeChainTask(length, true);
+	const TTask reversed = MakeChainTask(length, false);
+	const NSolver::TQuickPlanSolver quickPlan;
+	const NSolver::TDeltaBlueSolver deltaBlue;
+
+	BENCHMARK("quick plan, same edit, chain of " + std::to_string(length)) {
+		return quickPlan.TrySolve(task);
+	};
+	BENCHMARK("delta blue, same edit, chain of " + std::to_string(length)) {
+		return deltaBlue.TrySolve(task);
+	};
+	// every call reverses the whole chain, the worst case for the kept plan
+	bool even = false;
+	BENCHMARK("delta blue, alternating ends, chain of " + std::to_string(length)) {
+		even = !even;
+		return deltaBlue.TrySolve(even ? task : reversed);
+	};
+}
+
+}  // namespace
+
+}  // namespace NPropertyModels::NBenchmarks
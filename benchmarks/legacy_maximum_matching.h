@@ -0,0 +1,18 @@
+#pragma once
+
+#define NPROPERTY_MODELS_IMPL_ALLOWED
+#include "internal/solver/solver.h"
+#undef NPROPERTY_MODELS_IMPL_ALLOWED
+
+namespace NPropertyModels::NSolver {
+
+// maximum matching with Kuhn's algorithm as it was before Hopcroft-Karp,
+// kept to compare against
+class TLegacyMaximumMatchingSolver {
+public:
+	[[nodiscard]] EApplicability IsApplicable(const TTask &task) const;
+
+	[[nodiscard]] std::optional<TSolution> TrySolve(const TTask &task) const;
+};
+
+}  // namespace NPropertyModels::NSolver
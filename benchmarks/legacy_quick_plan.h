@@ -0,0 +1,18 @@
+#pragma once
+
+#define NPROPERTY_MODELS_IMPL_ALLOWED
+#include "internal/solver/solver.h"
+#undef NPROPERTY_MODELS_IMPL_ALLOWED
+
+namespace NPropertyModels::NSolver {
+
+// QuickPlan on hash maps as it was before the graph moved to flat arrays,
+// kept to compare against
+class TLegacyQuickPlanSolver {
+public:
+	[[nodiscard]] EApplicability IsApplicable(const TTask &task) const;
+
+	[[nodiscard]] std::optional<TSolution> TrySolve(const TTask &task) const;
+};
+
+}  // namespace NPropertyModels::NSolver
@@ -0,0 +1,103 @@
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <string>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+#include "legacy_maximum_matching.h"
+#include "solver/maximum_matching.h"
+
+namespace NPropertyModels::NBenchmarks {
+
+namespace {
+
+using NSolver::TTask;
+
+// two-way equality between two properties
+void AddEquality(TTask &task, size_t a, size_t b) {
+	const size_t constraintId = task.ConstraintsCount++;
+	task.CSMs.push_back({.ConstraintId = constraintId, .InputPropertyIds = {a}, .OutputPropertyIds = {b}});
+	task.CSMs.push_back({.ConstraintId = constraintId, .InputPropertyIds = {b}, .OutputPropertyIds = {a}});
+}
+
+// a stay for every property, weaker than everything added before
+void AddStays(TTask &task) {
+	for (size_t id = 0; id < task.PropertiesCount; ++id) {
+		task.CSMs.push_back({.ConstraintId = task.ConstraintsCount++, .InputPropertyIds = {}, .OutputPropertyIds = {id}});
+	}
+}
+
+TTask MakeChainTask(size_t length) {
+	TTask task{.PropertiesCount = length + 1, .ConstraintsCount = 0, .CSMs{}};
+	for (size_t id = 0; id < length; ++id) {
+		AddEquality(task, id, id + 1);
+	}
+	AddStays(task);
+	return task;
+}
+
+// equalities between the neighbours of a side x side grid
+TTask MakeGridTask(size_t side) {
+	TTask task{.PropertiesCount = side * side, .ConstraintsCount = 0, .CSMs{}};
+	for (size_t row = 0; row < side; ++row) {
+		for (size_t column = 0; column < side; ++column) {
+			const size_t id = row * side + column;
+			if (column + 1 < side) {
+				AddEquality(task, id, id + 1);
+			}
+			if (row + 1 < side) {
+				AddEquality(task, id, id + side);
+			}
+		}
+	}
+	AddStays(task);
+	return task;
+}
+
+// every constraint may write one of three random properties, there are no
+// inputs, so this is only the matching
+TTask MakeRandomTask(size_t size) {
+	std::mt19937 random(42);
+	TTask task{.PropertiesCount = size, .ConstraintsCount = size, .CSMs{}};
+	for (size_t constraintId = 0; constraintId < size; ++constraintId) {
+		for (size_t csm = 0; csm < 3; ++csm) {
+			task.CSMs.push_back({.ConstraintId = constraintId, .InputPropertyIds = {}, .OutputPropertyIds = {random() % size}});
+		}
+	}
+	return task;
+}
+
+TEST_CASE("maximum matching with hopcroft-karp versus kuhn", "[!benchmark][maximum_matching]") {
+	const size_t size = GENERATE(1'000, 10'000);
+
+	const TTask chain = MakeChainTask(size);
+	const TTask grid = MakeGridTask(static_cast<size_t>(std::sqrt(size)));
+	const TTask bipartite = MakeRandomTask(size);
+	const NSolver::TMaximumMatchingSolver solver;
+	const NSolver::TLegacyMaximumMatchingSolver legacySolver;
+
+	BENCHMARK("kuhn, chain of " + std::to_string(size)) {
+		return legacySolver.TrySolve(chain);
+	};
+	BENCHMARK("hopcroft-karp, chain of " + std::to_string(size)) {
+		return solver.TrySolve(chain);
+	};
+	BENCHMARK("kuhn, grid of " + std::to_string(size)) {
+		return legacySolver.TrySolve(grid);
+	};
+	BENCHMARK("hopcroft-karp, grid of " + std::to_string(size)) {
+		return solver.TrySolve(grid);
+	};
+	BENCHMARK("kuhn, random of " + std::to_string(size)) {
+		return legacySolver.TrySolve(bipartite);
+	};
+	BENCHMARK("hopcroft-karp, random of " + std::to_string(size)) {
+		return solver.TrySolve(bipartite);
+	};
+}
+
+}  // namespace
+
+}  // namespace NPropertyModels::NBenchmarks
@@ -0,0 +1,92 @@
+#include "property_models/model_table.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+
+namespace NPropertyModels::NBenchmarks {
+
+namespace {
+
+PM_PROPERTY_MODEL(TInstrument) {
+public:
+	PM_PROPERTY(double, Price, 100.0);
+	PM_PROPERTY(double, Quantity, 1.0);
+	PM_PROPERTY(double, Notional, 0.0);
+	PM_PROPERTY(double, Fee, 0.0);
+	PM_PROPERTY(double, Total, 0.0);
+
+public:
+	PM_CONSTRAINT(
+	    NotionalIsProduct,
+	    PM_CSM(
+	        PM_IN(Price, Quantity),
+	        PM_OUT(Notional),
+	        Notional = Price * Quantity;
+	    ),
+	    PM_CSM(
+	        PM_IN(Notional, Quantity),
+	        PM_OUT(Price),
+	        Price = Notional / Quantity;
+	    ),
+	);
+	PM_CONSTRAINT(
+	    FeeIsShare,
+	    PM_CSM(
+	        PM_IN(Notional),
+	        PM_OUT(Fee),
+	        Fee = Notional * 0.001;
+	    ),
+	);
+	PM_CONSTRAINT(
+	    TotalIsSum,
+	    PM_CSM(
+	        PM_IN(Notional, Fee),
+	        PM_OUT(Total),
+	        Total = Notional + Fee;
+	    ),
+	);
+};
+
+TEST_CASE("model table versus independent models", "[!benchmark][model_table]") {
+	const size_t rows = GENERATE(1'000, 100'000);
+
+	std::vector<double> prices(rows);
+	for (size_t row = 0; row < rows; ++row) {
+		prices[row] = 100.0 + static_cast<double>(row % 97);
+	}
+
+	std::vector<std::unique_ptr<TInstrument>> models;
+	for (size_t row = 0; row < rows; ++row) {
+		models.push_back(std::make_unique<TInstrument>());
+	}
+	TModelTable<TInstrument> table(rows);
+
+	double shift = 0.0;
+	BENCHMARK("independent models, " + std::to_string(rows) + " rows") {
+		shift += 1.0;
+		for (size_t row = 0; row < rows; ++row) {
+			models[row]->Price = prices[row] + shift;
+		}
+		return models.back()->Total.Get();
+	};
+
+	std::vector<double> column(rows);
+	BENCHMARK("model table, " + std::to_string(rows) + " rows") {
+		shift += 1.0;
+		for (size_t row = 0; row < rows; ++row) {
+			column[row] = prices[row] + shift;
+		}
+		table.SetColumn(&TInstrument::Price, column);
+		return table.Get(rows - 1, &TInstrument::Total);
+	};
+}
+
+}  // namespace
+
+}  // namespace NPropertyModels::NBenchmarks
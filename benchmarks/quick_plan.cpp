@@ -0,0 +1,96 @@
+#include <cstddef>
+#include <string>
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+#include "legacy_quick_plan.h"
+#include "solver/quick_plan.h"
+
+namespace NPropertyModels::NBenchmarks {
+
+namespace {
+
+using NSolver::TTask;
+
+// a chain of two-way equalities between neighbours, every property has a
+// stay, the stays get weaker along the chain
+TTask MakeChainTask(size_t length) {
+	TTask task{
+	    .PropertiesCount = length + 1,
+	    .ConstraintsCount = 2 * length + 1,
+	    .CSMs{},
+	};
+	for (size_t id = 0; id < length; ++id) {
+		task.CSMs.push_back({.ConstraintId = id, .InputPropertyIds = {id}, .OutputPropertyIds = {id + 1}});
+		task.CSMs.push_back({.ConstraintId = id, .InputPropertyIds = {id + 1}, .OutputPropertyIds = {id}});
+	}
+	for (size_t id = 0; id <= length; ++id) {
+		task.CSMs.push_back({.ConstraintId = length + id, .InputPropertyIds = {}, .OutputPropertyIds = {id}});
+	}
+	return task;
+}
+
+// sums a + b = c over a ladder, each sum shares a property with the next
+TTask MakeLadderTask(size_t length) {
+	const size_t propertiesCount = 2 * length + 1;
+	TTask task{
+	    .PropertiesCount = propertiesCount,
+	    .ConstraintsCount = length + propertiesCount,
+	    .CSMs{},
+	};
+	for (size_t id = 0; id < length; ++id) {
+		size_t a = 2 * id;
+		size_t b = 2 * id + 1;
+		size_t c = 2 * id + 2;
+		task.CSMs.push_back({.ConstraintId = id, .InputPropertyIds = {a, b}, .OutputPropertyIds = {c}});
+		task.CSMs.push_back({.ConstraintId = id, .InputPropertyIds = {a, c}, .OutputPropertyIds = {b}});
+		task.CSMs.push_back({.ConstraintId = id, .InputPropertyIds = {b, c}, .OutputPropertyIds = {a}});
+	}
+	for (size_t id = 0; id < propertiesCount; ++id) {
+		task.CSMs.push_back({.ConstraintId = length + id, .InputPropertyIds = {}, .OutputPropertyIds = {id}});
+	}
+	return task;
+}
+
+TEST_CASE("quick plan on flat arrays versus hash maps", "[!benchmark][quick_plan]") {
+	const size_t length = GENERATE(100, 400);
+
+	const TTask chain = MakeChainTask(length);
+	const TTask ladder = MakeLadderTask(length);
+	const NSolver::TQuickPlanSolver solver;
+	const NSolver::TLegacyQuickPlanSolver legacySolver;
+
+	BENCHMARK("legacy, chain of " + std::to_string(length)) {
+		return legacySolver.TrySolve(chain);
+	};
+	BENCHMARK("flat, chain of " + std::to_string(length)) {
+		return solver.TrySolve(chain);
+	};
+	BENCHMARK("legacy, ladder of " + std::to_string(length)) {
+		return legacySolver.TrySolve(ladder);
+	};
+	BENCHMARK("flat, ladder of " + std::to_string(length)) {
+		return solver.TrySolve(ladder);
+	};
+}
+
+// the legacy solver is too slow for these sizes
+TEST_CASE("quick plan scaling", "[!benchmark][quick_plan]") {
+	const size_t length = GENERATE(1'000, 2'000, 4'000);
+
+	const TTask chain = MakeChainTask(length);
+	const TTask ladder = MakeLadderTask(length);
+	const NSolver::TQuickPlanSolver solver;
+
+	BENCHMARK("chain of " + std::to_string(length)) {
+		return solver.TrySolve(chain);
+	};
+	BENCHMARK("ladder of " + std::to_string(length)) {
+		return solver.TrySolve(ladder);
+	};
+}
+
+}  // namespace
+
+}  // namespace NPropertyModels::NBenchmarks
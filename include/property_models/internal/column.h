@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef NPROPERTY_MODELS_IMPL_ALLOWED
+#error "This header may not be included directly. Please include \"property_models/model.h\" instead"
+#endif
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "fwd.h"
+
+namespace NPropertyModels {
+
+// The values of one declared property for every row of a model table. CSMs
+// work on properties of a model, so a table runs them on a single cursor
+// model and copies the values of a row in and out of it.
+template <typename TModel>
+class TColumn {
+public:
+	virtual ~TColumn() = default;
+
+	// copies the value of the row into the property of the cursor
+	virtual void Load(size_t row, TModel &cursor) const = 0;
+	// copies the value of the property of the cursor into the row
+	virtual void Store(size_t row, TModel &cursor) = 0;
+};
+
+template <typename TValue, typename TModel>
+class TTypedColumn final : public TColumn<TModel> {
+public:
+	// filled with the value the property has in the prototype
+	TTypedColumn(TModel &prototype, size_t offset, size_t size)
+	    : Offset_(offset), Values_(size, GetProperty(prototype).Value_) {
+	}
+
+	[[nodiscard]] static std::unique_ptr<TColumn<TModel>> Make(TModel &prototype, size_t offset, size_t size) {
+		return std::make_unique<TTypedColumn>(prototype, offset, size);
+	}
+
+	void Load(size_t row, TModel &cursor) const override {
+		GetProperty(cursor).Value_ = Values_[row];
+	}
+
+	void Store(size_t row, TModel &cursor) override {
+		Values_[row] = GetProperty(cursor).Value_;
+	}
+
+	[[nodiscard]] std::vector<TValue> &GetValues() {
+		return Values_;
+	}
+
+private:
+	[[nodiscard]] TProperty<TValue, TModel> &GetProperty(TModel &model) const {
+		return *std::launder(reinterpret_cast<TProperty<TValue, TModel> *>(reinterpret_cast<std::byte *>(&model) + Offset_));
+	}
+
+private:
+	// of the property in the model, the same for every instance
+	size_t Offset_;
+	std::vector<TValue> Values_;
+};
+
+// Where a declared property is in the model and how a table stores it.
+template <typename TModel>
+struct TPropertyType {
+	size_t Offset = 0;
+	std::unique_ptr<TColumn<TModel>> (*MakeColumn)(TModel &prototype, size_t offset, size_t size) = nullptr;
+};
+
+}  // namespace NPropertyModels
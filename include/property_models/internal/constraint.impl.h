@@ -2,6 +2,13 @@
 #error "This header may not be included directly. Please include \"property_models/model.h\" instead"
 #endif
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include "csm.h"
 
 namespace NPropertyModels {
@@ -13,8 +20,13 @@ template <typename TModel>
 
 template <typename TModel>
 void TConstraint<TModel>::SetImportance(size_t importance) {
+	if (Importance_ == importance) {
+		return;
+	}
+
+	Model_.OnConstraintBeforeSet(Id_);
 	Importance_ = importance;
-	OnSet();
+	Model_.OnConstraintImportanceSet(Id_);
 }
 
 template <typename TModel>
@@ -28,7 +40,8 @@ void TConstraint<TModel>::Enable() {
 		return;
 	}
 
-	Enabled_ = true;
+	Model_.OnConstraintBeforeSet(Id_);
+	SetEnabled(true);
 	OnSet();
 }
 
@@ -38,7 +51,8 @@ void TConstraint<TModel>::Disable() {
 		return;
 	}
 
-	Enabled_ = false;
+	Model_.OnConstraintBeforeSet(Id_);
+	SetEnabled(false);
 	OnSet();
 }
 
@@ -52,31 +66,63 @@ template <typename TModel>
 	return IsFulfilled();
 }
 
+template <typename TModel>
+[[nodiscard]] size_t TConstraint<TModel>::GetId() const {
+	return Id_;
+}
+
+template <typename TModel>
+template <typename... TArgs>
+void TConstraint<TModel>::RegisterCallback(TArgs&&... args) {
+	Model_.GetCallbacks().Constraints[Id_] = std::function<void()>{std::forward<TArgs>(args)...};
+}
+
+template <typename TModel>
+void TConstraint<TModel>::UnregisterCallback() {
+	if (Model_.Callbacks_) {
+		Model_.Callbacks_->Constraints[Id_] = {};
+	}
+}
+
 template <typename TModel>
 template <typename... T>
-    requires((std::same_as<std::remove_cvref_t<T>, TCSM<TModel>> && ...))
-TConstraint<TModel>::TConstraint(TModel& model, size_t importance, T&&... csms)
-    : Model_(model), Id_(Model_.RegisterConstraint(*this)), Importance_(importance), CSMs_{std::forward<T>(csms)...} {
+    requires((std::is_invocable_r_v<TCSM<TModel>, T> && ...))
+TConstraint<TModel>::TConstraint(TModel& model, size_t importance, T&&... makeCSMs)
+    : Model_(model),
+      Id_(Model_.DeclareConstraint(*this)),
+      Importance_(importance),
+      CSMs_(&TSchema<TModel>::Get().GetCSMs(Id_, std::forward<T>(makeCSMs)...)) {
 }
 
 template <typename TModel>
 template <typename... T>
-    requires((std::same_as<std::remove_cvref_t<T>, TCSM<TModel>> && ...))
-TConstraint<TModel>::TConstraint(TModel& model, T&&... csms)
-    : TConstraint(model, 0, std::forward<T>(csms)...) {
+    requires((std::is_invocable_r_v<TCSM<TModel>, T> && ...))
+TConstraint<TModel>::TConstraint(TModel& model, T&&... makeCSMs)
+    : TConstraint(model, 0, std::forward<T>(makeCSMs)...) {
 }
 
 template <typename TModel>
-TConstraint<TModel>::~TConstraint() = default;
+TConstraint<TModel>::TConstraint(TModel& model, size_t importance, std::vector<TCSM<TModel>> csms)
+    : Model_(model),
+      Id_(Model_.RegisterConstraint(*this)),
+      Importance_(importance),
+      CSMs_(nullptr),
+      OwnCSMs_(std::make_unique<const std::vector<TCSM<TModel>>>(std::move(csms))) {
+	CSMs_ = OwnCSMs_.get();
+	Model_.OnConstraintAttached(Id_);
+}
 
 template <typename TModel>
-[[nodiscard]] std::vector<std::reference_wrapper<TCSM<TModel>>> TConstraint<TModel>::GetCSMs() {
-	std::vector<std::reference_wrapper<TCSM<TModel>>> result;
-	result.reserve(CSMs_.size());
-	for (auto& csm : CSMs_) {
-		result.emplace_back(csm);
+TConstraint<TModel>::~TConstraint() {
+	// the model is being destroyed, there is nothing to keep consistent
+	if (!Model_.IsDeclaredConstraint(Id_)) {
+		Model_.DetachConstraint(Id_);
 	}
-	return result;
+}
+
+template <typename TModel>
+[[nodiscard]] const std::vector<TCSM<TModel>>& TConstraint<TModel>::GetCSMs() const {
+	return *CSMs_;
 }
 
 template <typename TModel>
@@ -84,5 +130,15 @@ void TConstraint<TModel>::OnSet() {
 	Model_.OnConstraintSet(Id_);
 }
 
+template <typename TModel>
+void TConstraint<TModel>::SetEnabled(bool enabled) {
+	std::atomic_ref<bool>(Enabled_).store(enabled, std::memory_order_relaxed);
+}
+
+template <typename TModel>
+void TConstraint<TModel>::SetFulfilled(bool fulfilled) {
+	std::atomic_ref<bool>(Fulfilled_).store(fulfilled, std::memory_order_relaxed);
+}
+
 }  // namespace NPropertyModels
 
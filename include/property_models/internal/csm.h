@@ -5,6 +5,8 @@
 #endif
 
 #include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace NPropertyModels {
@@ -12,39 +14,58 @@ namespace NPropertyModels {
 template <typename>
 class TPropertyModel;
 
+template <typename>
+class TModelTable;
+
 template <typename TModel>
 class TCSM {
 public:
 	TCSM() = delete;
 
+	// A method of a constraint attached at runtime. The function may capture
+	// the properties it works on and accesses them directly, it must only
+	// read the inputs and write the outputs.
+	template <typename TFunction>
+	[[nodiscard]] static TCSM Make(std::vector<size_t> inputPropertyIds, std::vector<size_t> outputPropertyIds, TFunction &&function) {
+		TCSM csm(std::move(inputPropertyIds), std::move(outputPropertyIds), nullptr);
+		csm.Function_ = std::make_shared<const std::function<void(TModel &)>>(std::forward<TFunction>(function));
+		return csm;
+	}
+
 private:
 	friend TModel;
 	friend TPropertyModel<TModel>;
+	friend TModelTable<TModel>;
+
+	using TApply = void (*)(TModel &);
 
-	TCSM(std::vector<size_t> inputPropertyIds, std::vector<size_t> outputPropertyIds, std::function<void()> apply)
-	    : InputPropertyIds_(std::move(inputPropertyIds)), OutputPropertyIds_(std::move(outputPropertyIds)), Apply_(std::move(apply)) {
+	TCSM(std::vector<size_t> inputPropertyIds, std::vector<size_t> outputPropertyIds, TApply apply)
+	    : InputPropertyIds_(std::move(inputPropertyIds)), OutputPropertyIds_(std::move(outputPropertyIds)), Apply_(apply) {
 	}
 
 private:
-	[[nodiscard]] std::vector<size_t> GetInputPropertyIds() const {
+	[[nodiscard]] const std::vector<size_t> &GetInputPropertyIds() const {
 		return InputPropertyIds_;
 	}
 
-	[[nodiscard]] std::vector<size_t> GetOutputPropertyIds() const {
+	[[nodiscard]] const std::vector<size_t> &GetOutputPropertyIds() const {
 		return OutputPropertyIds_;
 	}
 
-	void Apply() {
-		if (!Apply_) {
-			return;
+	void Apply(TModel &model) const {
+		if (Apply_) {
+			Apply_(model);
+		} else if (Function_) {
+			(*Function_)(model);
 		}
-		Apply_();
 	}
 
 private:
 	std::vector<size_t> InputPropertyIds_;
 	std::vector<size_t> OutputPropertyIds_;
-	std::function<void()> Apply_;
+	TApply Apply_ = nullptr;
+	// only set for CSMs made at runtime, shared between copies
+	std::shared_ptr<const std::function<void(TModel &)>> Function_;
 };
 
 }  // namespace NPropertyModels
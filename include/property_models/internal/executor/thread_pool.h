@@ -0,0 +1,65 @@
+#pragma once
+
+#ifndef NPROPERTY_MODELS_IMPL_ALLOWED
+#error "This header may not be included directly. Please include \"property_models/model.h\" instead"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace NPropertyModels::NExecutor {
+
+// Fixed set of workers with a deque each. Workers take their own work from
+// the back and steal from the front of other deques once they run out.
+class TThreadPool {
+public:
+	// the calling thread of Run counts as one of the threads
+	explicit TThreadPool(size_t threadsCount);
+	TThreadPool(const TThreadPool &) = delete;
+	TThreadPool(TThreadPool &&) = delete;
+	TThreadPool &operator=(const TThreadPool &) = delete;
+	TThreadPool &operator=(TThreadPool &&) = delete;
+	~TThreadPool();
+
+	[[nodiscard]] size_t GetThreadsCount() const;
+
+	// Calls task(index) for every index below count and returns when all of
+	// them have finished, rethrowing the first exception thrown by a task.
+	void Run(size_t count, const std::function<void(size_t)> &task);
+
+private:
+	struct TQueue {
+		std::mutex Mutex;
+		// (generation, index)
+		std::deque<std::pair<size_t, size_t>> Items;
+	};
+
+	bool TryPop(size_t worker, size_t generation, size_t &index);
+	void Work(size_t worker, size_t generation, const std::function<void(size_t)> &task);
+	void Loop(size_t worker);
+
+private:
+	std::vector<std::unique_ptr<TQueue>> Queues_;
+	std::vector<std::thread> Threads_;
+
+	std::mutex Mutex_;
+	std::condition_variable WakeUp_;
+	std::condition_variable Done_;
+	const std::function<void(size_t)> *Task_ = nullptr;
+	size_t Generation_ = 0;
+	bool Stopping_ = false;
+	std::atomic<size_t> Remaining_ = 0;
+	std::exception_ptr Error_;
+};
+
+}  // namespace NPropertyModels::NExecutor
@@ -17,6 +17,15 @@ class TProperty;
 template <typename TModel>
 class TConstraint;
 
+template <typename TModel>
+class TModelTable;
+
+template <typename TModel>
+class TSnapshotReader;
+
+template <typename TValue, typename TModel>
+class TTypedColumn;
+
 // internal
 enum class EAccess : uint8_t;
 
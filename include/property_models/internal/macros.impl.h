@@ -7,9 +7,9 @@ namespace NPropertyModels {
 #define NPROPERTY_MODELS_PROPERTY_MODEL_IMPL(name) \
 	class name : public NPropertyModels::TPropertyModel<name>
 
-#define NPROPERTY_MODELS_PROPERTY_IMPL(type, name, ...) \
-	NPropertyModels::TProperty<type, TThis> name {      \
-		*this __VA_OPT__(, ) __VA_ARGS__                \
+#define NPROPERTY_MODELS_PROPERTY_IMPL(type, name, ...)                \
+	NPropertyModels::TProperty<type, TThis> name {                     \
+		NPropertyModels::TDeclared{}, *this __VA_OPT__(, ) __VA_ARGS__ \
 	}
 
 #define NPROPERTY_MODELS_IMPORTANCE_IMPL(num) num
@@ -20,25 +20,39 @@ namespace NPropertyModels {
 
 #define NPROPERTY_MODELS_IN_IMPL(...) __VA_ARGS__
 #define NPROPERTY_MODELS_OUT_IMPL(...) __VA_ARGS__
-#define NPROPERTY_MODELS_CSM_DEFINE_IN(...) __VA_OPT__(auto [__VA_ARGS__] = getIn();)
-#define NPROPERTY_MODELS_CSM_DEFINE_OUT(...) __VA_OPT__(auto [__VA_ARGS__] = getOut();)
-#define NPROPERTY_MODELS_CSM_IMPL(in_args, out_args, ...)                                                \
-	[this]() -> NPropertyModels::TCSM<TThis> {                                                           \
-		std::vector<size_t> inIds = NPropertyModels::GetIds<TThis>(in_args);                             \
-		std::vector<size_t> outIds = NPropertyModels::GetIds<TThis>(out_args);                           \
-		auto getIn = [this]() {                                                                          \
-			return NPropertyModels::ViewProperties<NPropertyModels::EAccess::READ, TThis>(in_args);      \
-		};                                                                                               \
-		auto getOut = [this]() {                                                                         \
-			return NPropertyModels::ViewProperties<NPropertyModels::EAccess::WRITE, TThis>(out_args);    \
-		};                                                                                               \
-		std::function<void()> apply = [getIn = std::move(getIn), getOut = std::move(getOut)]() -> void { \
-			NPROPERTY_MODELS_CSM_DEFINE_IN(in_args)                                                      \
-			NPROPERTY_MODELS_CSM_DEFINE_OUT(out_args)                                                    \
-			__VA_ARGS__                                                                                  \
-		};                                                                                               \
-		return {std::move(inIds), std::move(outIds), std::move(apply)};                                  \
-	}()
+
+// NPROPERTY_MODELS_SELF_MEMBERS(A, B) expands to pmSelf.A, pmSelf.B
+#define NPROPERTY_MODELS_PARENS ()
+#define NPROPERTY_MODELS_EXPAND(...) NPROPERTY_MODELS_EXPAND4(NPROPERTY_MODELS_EXPAND4(NPROPERTY_MODELS_EXPAND4(NPROPERTY_MODELS_EXPAND4(__VA_ARGS__))))
+#define NPROPERTY_MODELS_EXPAND4(...) NPROPERTY_MODELS_EXPAND3(NPROPERTY_MODELS_EXPAND3(NPROPERTY_MODELS_EXPAND3(NPROPERTY_MODELS_EXPAND3(__VA_ARGS__))))
+#define NPROPERTY_MODELS_EXPAND3(...) NPROPERTY_MODELS_EXPAND2(NPROPERTY_MODELS_EXPAND2(NPROPERTY_MODELS_EXPAND2(NPROPERTY_MODELS_EXPAND2(__VA_ARGS__))))
+#define NPROPERTY_MODELS_EXPAND2(...) NPROPERTY_MODELS_EXPAND1(NPROPERTY_MODELS_EXPAND1(NPROPERTY_MODELS_EXPAND1(NPROPERTY_MODELS_EXPAND1(__VA_ARGS__))))
+#define NPROPERTY_MODELS_EXPAND1(...) __VA_ARGS__
+#define NPROPERTY_MODELS_SELF_MEMBERS(...) __VA_OPT__(NPROPERTY_MODELS_EXPAND(NPROPERTY_MODELS_SELF_MEMBERS_HELPER(__VA_ARGS__)))
+#define NPROPERTY_MODELS_SELF_MEMBERS_HELPER(name, ...) \
+	pmSelf.name __VA_OPT__(, NPROPERTY_MODELS_SELF_MEMBERS_AGAIN NPROPERTY_MODELS_PARENS(__VA_ARGS__))
+#define NPROPERTY_MODELS_SELF_MEMBERS_AGAIN() NPROPERTY_MODELS_SELF_MEMBERS_HELPER
+
+#define NPROPERTY_MODELS_CSM_DEFINE_IN(...) \
+	__VA_OPT__(auto [__VA_ARGS__] = NPropertyModels::ViewProperties<NPropertyModels::EAccess::READ, TThis>(NPROPERTY_MODELS_SELF_MEMBERS(__VA_ARGS__));)
+#define NPROPERTY_MODELS_CSM_DEFINE_OUT(...) \
+	__VA_OPT__(auto [__VA_ARGS__] = NPropertyModels::ViewProperties<NPropertyModels::EAccess::WRITE, TThis>(NPROPERTY_MODELS_SELF_MEMBERS(__VA_ARGS__));)
+
+// The method body is a captureless lambda receiving the model, so it is
+// stored as a plain function pointer. The CSM itself is only made for the
+// first instance of the model type and kept in its schema.
+#define NPROPERTY_MODELS_CSM_IMPL(in_args, out_args, ...)             \
+	[this]() -> NPropertyModels::TCSM<TThis> {                        \
+		return {                                                      \
+		    NPropertyModels::GetIds<TThis>(in_args),                  \
+		    NPropertyModels::GetIds<TThis>(out_args),                 \
+		    []([[maybe_unused]] TThis &pmSelf) -> void {              \
+			    NPROPERTY_MODELS_CSM_DEFINE_IN(in_args)               \
+			    NPROPERTY_MODELS_CSM_DEFINE_OUT(out_args)             \
+			    __VA_ARGS__                                           \
+		    },                                                        \
+		};                                                            \
+	}
 
 }  // namespace NPropertyModels
 
@@ -0,0 +1,309 @@
+#ifndef NPROPERTY_MODELS_IMPL_ALLOWED
+#error "This header may not be included directly. Please include \"property_models/model_table.h\" instead"
+#endif
+
+#include <algorithm>
+#include <concepts>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+
+namespace NPropertyModels {
+
+template <typename TModel>
+TModelTable<TModel>::TModelTable(size_t size)
+    : RowGroups_(size, 0), RowPositions_(size), RowStates_(size, ERowState::CLEAN) {
+	TPropertyModel<TModel> &cursor = GetBase(Cursor_);
+	cursor.MakeTableRow();
+	auto types = TSchema<TModel>::Get().GetProperties();
+	if (types.size() < cursor.StayOrder_.Size()) {
+		throw std::logic_error("Model tables can only store declared properties.");
+	}
+	for (size_t id = 0; id < cursor.StayOrder_.Size(); ++id) {
+		Columns_.push_back(types[id].MakeColumn(Cursor_, types[id].Offset, size));
+	}
+
+	// all rows start with the edit pattern of a new model
+	auto group = std::make_unique<TGroup>();
+	group->Planner = std::make_unique<TModel>();
+	// the planner only collects edits, it is executed on the rows
+	GetBase(*group->Planner).DoFreeze();
+	group->Key.assign(cursor.StayOrder_.begin(), cursor.StayOrder_.end());
+	for (size_t row = 0; row < size; ++row) {
+		RowPositions_[row] = row;
+		group->Rows.push_back(row);
+	}
+	GroupIds_.emplace(group->Key, 0);
+	Groups_.push_back(std::move(group));
+	Update();
+}
+
+template <typename TModel>
+size_t TModelTable<TModel>::Size() const {
+	return RowGroups_.size();
+}
+
+template <typename TModel>
+template <typename TValue>
+typename std::vector<TValue>::const_reference TModelTable<TModel>::Get(size_t row, TProperty<TValue, TModel> TModel::*property) const {
+	return GetTypedColumn(property).GetValues()[row];
+}
+
+template <typename TModel>
+template <typename TValue>
+const std::vector<TValue> &TModelTable<TModel>::GetColumn(TProperty<TValue, TModel> TModel::*property) const {
+	return GetTypedColumn(property).GetValues();
+}
+
+template <typename TModel>
+template <typename TValue, typename TOther>
+void TModelTable<TModel>::Set(size_t row, TProperty<TValue, TModel> TModel::*property, TOther &&value) {
+	auto &values = GetTypedColumn(property).GetValues();
+	if constexpr (std::equality_comparable_with<TValue, TOther>) {
+		if (static_cast<bool>(values[row] == value)) {
+			return;
+		}
+	}
+
+	values[row] = std::forward<TOther>(value);
+	EditedRows_.push_back(row);
+	EditRows((Cursor_.*property).GetId());
+	Update();
+}
+
+template <typename TModel>
+template <typename TValue, typename TValues>
+void TModelTable<TModel>::SetColumn(TProperty<TValue, TModel> TModel::*property, const TValues &values) {
+	auto &column = GetTypedColumn(property).GetValues();
+	for (size_t row = 0; row < column.size(); ++row) {
+		if constexpr (std::equality_comparable_with<TValue, decltype(values[row])>) {
+			if (static_cast<bool>(column[row] == values[row])) {
+				continue;
+			}
+		}
+		column[row] = values[row];
+		EditedRows_.push_back(row);
+	}
+	EditRows((Cursor_.*property).GetId());
+	Update();
+}
+
+template <typename TModel>
+const TConstraint<TModel> &TModelTable<TModel>::GetConstraint(size_t row, TConstraint<TModel> TModel::*constraint) const {
+	return (*Groups_[RowGroups_[row]]->Planner).*constraint;
+}
+
+template <typename TModel>
+void TModelTable<TModel>::SetImportance(TConstraint<TModel> TModel::*constraint, size_t importance) {
+	for (auto &group : Groups_) {
+		((*group->Planner).*constraint).SetImportance(importance);
+	}
+	Update();
+}
+
+template <typename TModel>
+void TModelTable<TModel>::Enable(TConstraint<TModel> TModel::*constraint) {
+	for (auto &group : Groups_) {
+		((*group->Planner).*constraint).Enable();
+	}
+	Update();
+}
+
+template <typename TModel>
+void TModelTable<TModel>::Disable(TConstraint<TModel> TModel::*constraint) {
+	for (auto &group : Groups_) {
+		((*group->Planner).*constraint).Disable();
+	}
+	Update();
+}
+
+template <typename TModel>
+size_t TModelTable<TModel>::GetGroupsCount() const {
+	return Groups_.size();
+}
+
+template <typename TModel>
+template <typename TValue>
+TTypedColumn<TValue, TModel> &TModelTable<TModel>::GetTypedColumn(TProperty<TValue, TModel> TModel::*property) const {
+	// the member pointer gives the type of the column
+	return static_cast<TTypedColumn<TValue, TModel> &>(*Columns_[(Cursor_.*property).GetId()]);
+}
+
+template <typename TModel>
+TPropertyModel<TModel> &TModelTable<TModel>::GetBase(TModel &model) {
+	return static_cast<TPropertyModel<TModel> &>(model);
+}
+
+template <typename TModel>
+void TModelTable<TModel>::EditRows(size_t propertyId) {
+	// rows whose last edit was the same property keep their plan, the others
+	// move to the group of their new edit pattern
+	TargetGroups_.assign(Groups_.size(), NONE);
+	for (const auto &row : EditedRows_) {
+		size_t groupId = RowGroups_[row];
+		TGroup &group = *Groups_[groupId];
+		if (group.Key.front() == propertyId) {
+			GetBase(*group.Planner).OnPropertySet(propertyId);
+			MarkRow(group, row, ERowState::EDITED);
+			continue;
+		}
+		if (TargetGroups_[groupId] == NONE) {
+			TargetGroups_[groupId] = FindGroup(groupId, propertyId);
+		}
+		MoveRow(row, TargetGroups_[groupId]);
+	}
+	EditedRows_.clear();
+	RemoveEmptyGroups();
+}
+
+template <typename TModel>
+size_t TModelTable<TModel>::FindGroup(size_t sourceGroupId, size_t propertyId) {
+	const TGroup &source = *Groups_[sourceGroupId];
+	Key_ = source.Key;
+	auto edited = std::ranges::find(Key_, propertyId);
+	std::rotate(Key_.begin(), edited, edited + 1);
+	if (auto found = GroupIds_.find(Key_); found != GroupIds_.end()) {
+		return found->second;
+	}
+
+	auto group = std::make_unique<TGroup>();
+	group->Planner = std::make_unique<TModel>();
+	TPropertyModel<TModel> &planner = GetBase(*group->Planner);
+	planner.DoFreeze();
+	// replaying the edit pattern from the weakest stay on rebuilds it
+	for (const auto &id : std::views::reverse(Key_)) {
+		planner.OnPropertySet(id);
+	}
+	const auto &sourceConstraints = GetBase(*source.Planner).Constraints_;
+	for (size_t id = 0; id < sourceConstraints.size(); ++id) {
+		TConstraint<TModel> &constraint = *planner.Constraints_[id];
+		constraint.SetImportance(sourceConstraints[id]->GetImportance());
+		if (sourceConstraints[id]->IsEnabled()) {
+			constraint.Enable();
+		} else {
+			constraint.Disable();
+		}
+	}
+
+	group->Key = Key_;
+	GroupIds_.emplace(Key_, Groups_.size());
+	Groups_.push_back(std::move(group));
+	return Groups_.size() - 1;
+}
+
+template <typename TModel>
+void TModelTable<TModel>::MoveRow(size_t row, size_t groupId) {
+	TGroup &source = *Groups_[RowGroups_[row]];
+	size_t last = source.Rows.back();
+	source.Rows[RowPositions_[row]] = last;
+	RowPositions_[last] = RowPositions_[row];
+	source.Rows.pop_back();
+
+	TGroup &target = *Groups_[groupId];
+	RowGroups_[row] = groupId;
+	RowPositions_[row] = target.Rows.size();
+	target.Rows.push_back(row);
+	MarkRow(target, row, ERowState::MOVED);
+}
+
+template <typename TModel>
+void TModelTable<TModel>::MarkRow(TGroup &group, size_t row, ERowState state) {
+	if (RowStates_[row] == ERowState::CLEAN) {
+		group.PendingRows.push_back(row);
+	}
+	RowStates_[row] = std::max(RowStates_[row], state);
+}
+
+template <typename TModel>
+void TModelTable<TModel>::RemoveEmptyGroups() {
+	for (size_t groupId = 0; groupId < Groups_.size();) {
+		if (!Groups_[groupId]->Rows.empty()) {
+			++groupId;
+			continue;
+		}
+
+		GroupIds_.erase(Groups_[groupId]->Key);
+		Groups_[groupId] = std::move(Groups_.back());
+		Groups_.pop_back();
+		if (groupId == Groups_.size()) {
+			break;
+		}
+		GroupIds_[Groups_[groupId]->Key] = groupId;
+		for (const auto &row : Groups_[groupId]->Rows) {
+			RowGroups_[row] = groupId;
+		}
+	}
+}
+
+template <typename TModel>
+void TModelTable<TModel>::PrepareBatch(TBatch &batch) {
+	// inputs are loaded for the CSMs to read, outputs so that a CSM that
+	// leaves an output alone stores the value of its own row
+	Accessed_.assign(Columns_.size(), 0);
+	batch.LoadIds.clear();
+	batch.StoreIds.clear();
+	for (const TCSM<TModel> *csm : batch.CSMs) {
+		for (const auto &id : csm->GetInputPropertyIds()) {
+			if (!Accessed_[id]) {
+				Accessed_[id] = 1;
+				batch.LoadIds.push_back(id);
+			}
+		}
+		for (const auto &id : csm->GetOutputPropertyIds()) {
+			if (!(Accessed_[id] & 2)) {
+				if (!Accessed_[id]) {
+					batch.LoadIds.push_back(id);
+				}
+				Accessed_[id] |= 2;
+				batch.StoreIds.push_back(id);
+			}
+		}
+	}
+}
+
+template <typename TModel>
+void TModelTable<TModel>::ExecuteRow(size_t row, const TBatch &batch) {
+	for (const auto &id : batch.LoadIds) {
+		Columns_[id]->Load(row, Cursor_);
+	}
+	for (const TCSM<TModel> *csm : batch.CSMs) {
+		csm->Apply(Cursor_);
+	}
+	for (const auto &id : batch.StoreIds) {
+		Columns_[id]->Store(row, Cursor_);
+	}
+}
+
+template <typename TModel>
+void TModelTable<TModel>::Update() {
+	for (auto &group : Groups_) {
+		TPropertyModel<TModel> &planner = GetBase(*group->Planner);
+		if (group->PendingRows.empty() && planner.PlanValid_) {
+			continue;
+		}
+
+		// a new plan has to be executed on every row, otherwise only edited
+		// rows are affected
+		bool allRows = planner.CollectRowCSMs(Affected_.CSMs);
+		PrepareBatch(Affected_);
+		bool moved = std::ranges::any_of(group->PendingRows, [this](size_t row) { return RowStates_[row] == ERowState::MOVED; });
+		if (moved) {
+			Planned_.CSMs = planner.PlannedCSMs_;
+			PrepareBatch(Planned_);
+		}
+
+		for (const auto &row : allRows ? group->Rows : group->PendingRows) {
+			if (RowStates_[row] == ERowState::MOVED) {
+				ExecuteRow(row, Planned_);
+			} else if (!Affected_.CSMs.empty()) {
+				ExecuteRow(row, Affected_);
+			}
+		}
+		for (const auto &row : group->PendingRows) {
+			RowStates_[row] = ERowState::CLEAN;
+		}
+		group->PendingRows.clear();
+	}
+}
+
+}  // namespace NPropertyModels
@@ -2,9 +2,15 @@
 #error "This header may not be included directly. Please include \"property_models/model.h\" instead"
 #endif
 
+#include <atomic>
+#include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace NPropertyModels {
@@ -12,11 +18,22 @@ namespace NPropertyModels {
 template <typename TValue, typename TModel>
 template <typename... TArgs>
 TProperty<TValue, TModel>::TProperty(TModel &model, TArgs &&...args)
-    : Model_(model), Id_(Model_.RegisterProperty()), Value_(std::forward<TArgs>(args)...) {
+    : Model_(model), Id_(Model_.AttachProperty()), Value_(std::forward<TArgs>(args)...) {
 }
 
 template <typename TValue, typename TModel>
-TProperty<TValue, TModel>::~TProperty() = default;
+template <typename... TArgs>
+TProperty<TValue, TModel>::TProperty(TDeclared, TModel &model, TArgs &&...args)
+    : Model_(model), Id_(Model_.DeclareProperty(*this)), Value_(std::forward<TArgs>(args)...) {
+}
+
+template <typename TValue, typename TModel>
+TProperty<TValue, TModel>::~TProperty() {
+	// the model is being destroyed, there is nothing to keep consistent
+	if (!Model_.IsDeclaredProperty(Id_)) {
+		Model_.DetachProperty(Id_);
+	}
+}
 
 template <typename TValue, typename TModel>
 TProperty<TValue, TModel>::operator const TValue &() const {
@@ -29,7 +46,12 @@ template <typename TValue, typename TModel>
 template <typename TOther>
 // NOLINTNEXTLINE
 TValue &TProperty<TValue, TModel>::operator=(TOther &&other) {
-	Value_ = std::forward<TOther>(other);
+	if (Equals(other)) {
+		return Value_;
+	}
+
+	OnBeforeSet();
+	Store(std::forward<TOther>(other));
 	OnSet();
 
 	return Value_;
@@ -37,12 +59,18 @@ TValue &TProperty<TValue, TModel>::operator=(TOther &&other) {
 
 template <typename TValue, typename TModel>
 const TValue &TProperty<TValue, TModel>::Get() const {
+	OnGet();
 	return Value_;
 }
 
 template <typename TValue, typename TModel>
 const TValue &TProperty<TValue, TModel>::Set(const TValue &value) {
-	Value_ = value;
+	if (Equals(value)) {
+		return Value_;
+	}
+
+	OnBeforeSet();
+	Store(value);
 	OnSet();
 
 	return Value_;
@@ -50,14 +78,68 @@ const TValue &TProperty<TValue, TModel>::Set(const TValue &value) {
 
 template <typename TValue, typename TModel>
 const TValue &TProperty<TValue, TModel>::Set(TValue &&value) {
-	Value_ = std::move(value);
+	if (Equals(value)) {
+		return Value_;
+	}
+
+	OnBeforeSet();
+	Store(std::move(value));
 	OnSet();
 
 	return Value_;
 }
 
+template <typename TValue, typename TModel>
+size_t TProperty<TValue, TModel>::GetId() const {
+	return Id_;
+}
+
+template <typename TValue, typename TModel>
+template <typename... TArgs>
+void TProperty<TValue, TModel>::RegisterCallback(TArgs &&...args) {
+	Model_.GetCallbacks().Properties[Id_] = std::function<void()>{std::forward<TArgs>(args)...};
+}
+
+template <typename TValue, typename TModel>
+void TProperty<TValue, TModel>::UnregisterCallback() {
+	if (Model_.Callbacks_) {
+		Model_.Callbacks_->Properties[Id_] = {};
+	}
+}
+
+template <typename TValue, typename TModel>
+template <typename TOther>
+bool TProperty<TValue, TModel>::Equals(const TOther &other) const {
+	// writing an equal value is not an edit and does not propagate
+	if constexpr (std::equality_comparable_with<TValue, TOther>) {
+		return static_cast<bool>(Value_ == other);
+	} else {
+		return false;
+	}
+}
+
+template <typename TValue, typename TModel>
+template <typename TOther>
+void TProperty<TValue, TModel>::Store(TOther &&other) {
+	if constexpr (IsSnapshotValue<TValue>()) {
+		TValue value = Value_;
+		value = std::forward<TOther>(other);
+		std::atomic_ref<TValue>(Value_).store(value, std::memory_order_relaxed);
+	} else {
+		Value_ = std::forward<TOther>(other);
+	}
+}
+
 template <typename TValue, typename TModel>
 void TProperty<TValue, TModel>::OnGet() const {
+	Model_.OnPropertyGet(Id_);
+}
+
+template <typename TValue, typename TModel>
+void TProperty<TValue, TModel>::OnBeforeSet() {
+	Model_.OnPropertyBeforeSet(Id_);
+	// the old value is only copied while speculating or recording history
+	Model_.SaveProperty(Id_, Value_);
 }
 
 template <typename TValue, typename TModel>
@@ -2,8 +2,23 @@
 #error "This header may not be included directly. Please include \"property_models/model.h\" instead"
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
-#include <unordered_set>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <variant>
 
 #include "solver/solver.h"
 
@@ -12,12 +27,27 @@ namespace NPropertyModels {
 template <typename TModel>
 template <typename... TArgs>
 void TPropertyModel<TModel>::RegisterCallback(TArgs &&...args) {
-	Callback_ = std::function<void()>{std::forward<TArgs>(args)...};
+	GetCallbacks().Model = std::function<void()>{std::forward<TArgs>(args)...};
 }
 
 template <typename TModel>
 void TPropertyModel<TModel>::UnregisterCallback() {
-	Callback_ = {};
+	if (Callbacks_) {
+		Callbacks_->Model = {};
+	}
+}
+
+template <typename TModel>
+template <typename... TArgs>
+void TPropertyModel<TModel>::RegisterChangesCallback(TArgs &&...args) {
+	GetCallbacks().Changes = std::function<void(const TChangeSet &)>{std::forward<TArgs>(args)...};
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::UnregisterChangesCallback() {
+	if (Callbacks_) {
+		Callbacks_->Changes = {};
+	}
 }
 
 // TFreezeGuard Implementation
@@ -37,140 +67,1494 @@ typename TPropertyModel<TModel>::TFreezeGuard TPropertyModel<TModel>::Freeze() {
 	return TFreezeGuard(*this);
 }
 
+// TSpeculationGuard Implementation
 template <typename TModel>
-size_t TPropertyModel<TModel>::RegisterProperty() {
-	PropertySetTime_.push_back(0);
-	return PropertySetTime_.size() - 1;
+TPropertyModel<TModel>::TSpeculationGuard::TSpeculationGuard(TPropertyModel &base)
+    : Base_(base) {
+	Base_.DoSpeculate();
 }
 
 template <typename TModel>
-size_t TPropertyModel<TModel>::RegisterConstraint(TConstraint<TThis> &constraint) {
-	Constraints_.push_back(constraint);
-	return Constraints_.size() - 1;
+TPropertyModel<TModel>::TSpeculationGuard::~TSpeculationGuard() {
+	Base_.DoRollback();
 }
 
 template <typename TModel>
-void TPropertyModel<TModel>::OnPropertySet(size_t id) {
-	if (Updating_) {
+typename TPropertyModel<TModel>::TSpeculationGuard TPropertyModel<TModel>::Speculate() {
+	return TSpeculationGuard(*this);
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::IsSpeculating() const {
+	return Speculation_ && !Speculation_->Begins.empty();
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::SetHistoryCapacity(size_t capacity) {
+	if (capacity == 0) {
+		History_.reset();
 		return;
-	};
+	}
+	if (!History_) {
+		History_ = std::make_unique<THistory>();
+		History_->Serials.resize(Dirty_.size(), 0);
+	}
+	ClearHistory();
+	History_->Slots.resize(capacity);
+}
 
-	PropertySetTime_[id] = ++Time_;
-	Update();
+template <typename TModel>
+size_t TPropertyModel<TModel>::GetUndoCount() const {
+	return History_ ? History_->Position : 0;
 }
 
 template <typename TModel>
-void TPropertyModel<TModel>::OnConstraintSet(size_t id) {
-	if (Updating_) {
+size_t TPropertyModel<TModel>::GetRedoCount() const {
+	return History_ ? History_->Count - History_->Position : 0;
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::Undo() {
+	if (GetUndoCount() == 0) {
+		return false;
+	}
+	THistory &history = *History_;
+	ApplyHistoryStep((history.First + history.Position - 1) % history.Slots.size(), true);
+	--history.Position;
+	return true;
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::Redo() {
+	if (GetRedoCount() == 0) {
+		return false;
+	}
+	THistory &history = *History_;
+	ApplyHistoryStep((history.First + history.Position) % history.Slots.size(), false);
+	++history.Position;
+	return true;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::SetPlanCacheCapacity(size_t capacity) {
+	GetSolverState().PlanCache.SetCapacity(capacity);
+}
+
+template <typename TModel>
+NSolver::TPlanCacheStats TPropertyModel<TModel>::GetPlanCacheStats() const {
+	return SolverState_ ? SolverState_->PlanCache.GetStats() : NSolver::TPlanCacheStats{};
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::SetLazyEvaluation(bool lazy) {
+	if (!lazy) {
+		FlushStale();
+	} else {
+		// stale values are computed outside of any recorded update
+		ClearHistory();
+	}
+	Lazy_ = lazy;
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::IsLazyEvaluation() const {
+	return Lazy_;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::SetPrecomputedPlans(bool precomputed) {
+	PrecomputedPlans_ = precomputed;
+	PlanValid_ = false;
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::IsPrecomputedPlans() const {
+	return PrecomputedPlans_;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::SetAsyncPlanning(bool async) {
+	if (!async) {
+		// the pending plan is dropped, the next update plans synchronously
+		AsyncPlanning_.reset();
 		return;
-	};
+	}
+	if (!AsyncPlanning_) {
+		AsyncPlanning_ = std::make_unique<TAsyncPlanning>();
+	}
+}
 
-	Update();
+template <typename TModel>
+bool TPropertyModel<TModel>::IsAsyncPlanning() const {
+	return AsyncPlanning_ != nullptr;
 }
 
 template <typename TModel>
-void TPropertyModel<TModel>::Update() {
-	if (Updating_) {
+bool TPropertyModel<TModel>::IsPlanPending() const {
+	return AsyncPlanning_ && AsyncPlanning_->PendingSolution.valid();
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::AwaitPlan() {
+	if (!IsPlanPending()) {
+		return;
+	}
+	AsyncPlanning_->PendingSolution.wait();
+	if (FreezeDepth_ > 0) {
 		return;
 	}
-	Updating_ = true;
+	Update();
+}
 
-	std::vector<size_t> propertyOrder(PropertySetTime_.size());
-	std::iota(propertyOrder.begin(), propertyOrder.end(), 0u);
-	std::ranges::sort(propertyOrder, [this](size_t a, size_t b) { return PropertySetTime_[a] > PropertySetTime_[b]; });
+template <typename TModel>
+void TPropertyModel<TModel>::SetParallelExecution(size_t threadsCount, size_t threshold) {
+	threshold = std::max<size_t>(threshold, 1);
+	if (threadsCount <= 1) {
+		ParallelExecution_.reset();
+		return;
+	}
+	if (!ParallelExecution_ || ParallelExecution_->ThreadPool.GetThreadsCount() != threadsCount) {
+		ParallelExecution_ = std::make_unique<TParallelExecution>(threadsCount, threshold);
+	}
+	ParallelExecution_->Threshold = threshold;
+}
 
-	std::vector<size_t> constraintOrder(Constraints_.size());
-	std::iota(constraintOrder.begin(), constraintOrder.end(), 0u);
-	std::ranges::sort(constraintOrder, [this](size_t a, size_t b) {
-		return Constraints_[a].get().GetImportance() < Constraints_[b].get().GetImportance();
-	});
+template <typename TModel>
+TExecutionStats TPropertyModel<TModel>::GetExecutionStats() const {
+	return ExecutionStats_;
+}
 
-	NSolver::TTask task{
-	    .PropertiesCount = PropertySetTime_.size(),
-	    .ConstraintsCount = Constraints_.size() + PropertySetTime_.size(),
-	};
-	std::vector<TCSM<TThis> *> backPointers;
+template <typename TModel>
+template <typename TFunction>
+std::optional<std::invoke_result_t<TFunction, const TSnapshotReader<TModel> &>> TPropertyModel<TModel>::ReadSnapshot(
+    TFunction &&function,
+    size_t maxAttempts
+) const {
+	if (Lazy_) {
+		throw std::logic_error("Snapshots are not available in lazy mode.");
+	}
 
-	for (size_t constraintNewId = 0; constraintNewId < constraintOrder.size(); ++constraintNewId) {
-		auto &constraint = Constraints_[constraintOrder[constraintNewId]].get();
-		if (!constraint.IsEnabled()) {
+	const TSnapshotReader<TModel> reader;
+	for (size_t attempt = 0; attempt < maxAttempts; ++attempt) {
+		uint64_t version = Version_.load(std::memory_order_acquire);
+		if (version % 2 == 1) {
+			std::this_thread::yield();
 			continue;
 		}
 
-		for (auto &csmWrap : constraint.GetCSMs()) {
-			TCSM<TThis> &csm = csmWrap.get();
+		auto result = function(reader);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (Version_.load(std::memory_order_relaxed) == version) {
+			return result;
+		}
+	}
+	return std::nullopt;
+}
+
+// TSnapshotReader Implementation
+template <typename TModel>
+template <typename TValue>
+TValue TSnapshotReader<TModel>::Get(const TProperty<TValue, TModel> &property) const {
+	static_assert(IsSnapshotValue<TValue>(), "Snapshots can only read trivially copyable values that are lock-free atomics.");
+	// the writer stores the value atomically, loading does not modify it
+	return std::atomic_ref<TValue>(const_cast<TValue &>(property.Value_)).load(std::memory_order_relaxed);
+}
 
-			task.CSMs.emplace_back(
-			    constraintNewId,
-			    csm.GetInputPropertyIds(),
-			    csm.GetOutputPropertyIds()
-			);
-			backPointers.push_back(&csm);
+template <typename TModel>
+bool TSnapshotReader<TModel>::IsFulfilled(const TConstraint<TModel> &constraint) const {
+	auto &enabled = const_cast<bool &>(constraint.Enabled_);
+	auto &fulfilled = const_cast<bool &>(constraint.Fulfilled_);
+	return std::atomic_ref<bool>(enabled).load(std::memory_order_relaxed) &&
+	       std::atomic_ref<bool>(fulfilled).load(std::memory_order_relaxed);
+}
+
+template <typename TModel>
+uint64_t TPropertyModel<TModel>::GetVersion() const {
+	return Version_.load(std::memory_order_acquire);
+}
+
+// TWriteGuard Implementation
+template <typename TModel>
+TPropertyModel<TModel>::TWriteGuard::TWriteGuard(TPropertyModel &base)
+    : Base_(base) {
+	Base_.Updating_ = true;
+	Base_.BeginWrite();
+}
+
+template <typename TModel>
+TPropertyModel<TModel>::TWriteGuard::~TWriteGuard() {
+	// also when a CSM or the solver throws, readers must not wait forever
+	Base_.Updating_ = false;
+	Base_.EndWrite();
+}
+
+template <typename TModel>
+size_t TPropertyModel<TModel>::RegisterProperty() {
+	size_t id = StayOrder_.Add();
+	if (id < Producers_.size()) {
+		// the id of a detached property
+		if (Speculation_) {
+			Speculation_->UndoDepths[id] = 0;
+		}
+		if (History_) {
+			History_->Serials[id] = 0;
 		}
+		return id;
+	}
+	Dirty_.push_back(0);
+	Producers_.push_back(nullptr);
+	Stale_.push_back(0);
+	if (Speculation_) {
+		Speculation_->UndoDepths.push_back(0);
+	}
+	if (History_) {
+		History_->Serials.push_back(0);
 	}
+	if (Callbacks_) {
+		Callbacks_->Properties.emplace_back();
+	}
+	return id;
+}
 
-	for (size_t stayConstraintId = 0; stayConstraintId < propertyOrder.size(); ++stayConstraintId) {
-		task.CSMs.emplace_back(
-		    Constraints_.size() + stayConstraintId,
-		    std::vector<size_t>{},
-		    std::vector<size_t>{propertyOrder[stayConstraintId]}
-		);
-		backPointers.push_back(nullptr);
+template <typename TModel>
+size_t TPropertyModel<TModel>::RegisterConstraint(TConstraint<TThis> &constraint) {
+	// the importance is not initialized yet
+	ConstraintOrderValid_ = false;
+	if (!FreeConstraintIds_.empty()) {
+		size_t id = FreeConstraintIds_.back();
+		FreeConstraintIds_.pop_back();
+		Constraints_[id] = &constraint;
+		ConstraintSerials_[id] = NextConstraintSerial_++;
+		return id;
+	}
+
+	Constraints_.push_back(&constraint);
+	ConstraintSerials_.push_back(NextConstraintSerial_++);
+	if (Callbacks_) {
+		Callbacks_->Constraints.emplace_back();
 	}
+	SelectedCSMs_.push_back(TStayOrder::NONE);
+	return Constraints_.size() - 1;
+}
 
-	NSolver::TSolver solver = NSolver::GetSolver();
-	auto maybeSolution = solver.TrySolve(task);
+template <typename TModel>
+template <typename TValue>
+size_t TPropertyModel<TModel>::DeclareProperty(TProperty<TValue, TThis> &property) {
+	size_t id = RegisterProperty();
+	++DeclaredPropertiesCount_;
+	auto offset = reinterpret_cast<const std::byte *>(&property) - reinterpret_cast<const std::byte *>(static_cast<const TModel *>(this));
+	TSchema<TModel>::Get().template AddProperty<TValue>(id, static_cast<size_t>(offset));
+	return id;
+}
 
-	if (!maybeSolution) {
-		throw std::logic_error("Property model is to complex to be resolved.");
+template <typename TModel>
+size_t TPropertyModel<TModel>::DeclareConstraint(TConstraint<TThis> &constraint) {
+	++DeclaredConstraintsCount_;
+	return RegisterConstraint(constraint);
+}
+
+template <typename TModel>
+size_t TPropertyModel<TModel>::AttachProperty() {
+	size_t id = RegisterProperty();
+	// no constraint uses it yet, the plan only gains a stay
+	OnStructureChanged();
+	return id;
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::IsDeclaredProperty(size_t id) const {
+	return id < DeclaredPropertiesCount_;
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::IsDeclaredConstraint(size_t id) const {
+	return id < DeclaredConstraintsCount_;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::DetachProperty(size_t id) {
+	StayOrder_.Remove(id);
+	if (LastSetPropertyId_ == id) {
+		LastSetPropertyId_.reset();
+	}
+	Producers_[id] = nullptr;
+	Stale_[id] = 0;
+	if (Callbacks_) {
+		Callbacks_->Properties[id] = {};
 	}
-	NSolver::TSolution &solution = maybeSolution.value();
+	OnStructureChanged();
+}
 
-	for (const auto &csmId : solution.CSMIds) {
-		if (!backPointers[csmId]) {
-			continue;
-		};
-		TCSM<TThis> &csm = *backPointers[csmId];
+template <typename TModel>
+void TPropertyModel<TModel>::DetachConstraint(size_t id) {
+	// its CSMs must not be evaluated lazily anymore, the outputs keep their
+	// current values
+	for (auto &csm : Constraints_[id]->GetCSMs()) {
+		for (const auto &outputId : csm.GetOutputPropertyIds()) {
+			if (Producers_[outputId] == &csm) {
+				Producers_[outputId] = nullptr;
+				Stale_[outputId] = 0;
+			}
+		}
+	}
+
+	Constraints_[id] = nullptr;
+	if (Callbacks_) {
+		Callbacks_->Constraints[id] = {};
+	}
+	SelectedCSMs_[id] = TStayOrder::NONE;
+	FreeConstraintIds_.push_back(id);
+	OnStructureChanged();
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::OnConstraintAttached(size_t id) {
+	OnStructureChanged();
+	if (FreezeDepth_ > 0 || Updating_) {
+		return;
+	}
+	try {
+		Update();
+	} catch (...) {
+		// the constructor of the constraint fails, its destructor does not
+		// run to detach it
+		DetachConstraint(id);
+		throw;
+	}
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::OnStructureChanged() {
+	// whole task signatures do not describe the structure, component keys do
+	Restructured_ = true;
+	StructureChanged_ = true;
+	// recorded entries may refer to detached properties and constraints
+	ClearHistory();
+	PlanValid_ = false;
+	ConstraintOrderValid_ = false;
+	if (SolverState_) {
+		SolverState_->PlanCache.Clear();
+	}
+	if (AsyncPlanning_) {
+		AsyncPlanning_->PendingSolution = {};
+	}
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::IsConstraintEnabled(size_t id) const {
+	return Constraints_[id] && Constraints_[id]->IsEnabled();
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::OnPropertyGet(size_t id) {
+	if (Stale_[id]) {
+		Evaluate(id);
+	}
+}
 
-		csm.Apply();
+template <typename TModel>
+void TPropertyModel<TModel>::OnPropertyBeforeSet(size_t id) {
+	if (Updating_ || Evaluating_ || TableRow_) {
+		return;
+	}
+	// an edit stays open until the update it triggers has finished
+	BeginWrite();
+	if (StaleIds_.empty()) {
+		return;
 	}
 
-	std::unordered_set<size_t> fulfilledConstraintIds;
-	for (const auto &csmId : solution.CSMIds) {
-		size_t newConstraintId = task.CSMs[csmId].ConstraintId;
-		if (newConstraintId >= constraintOrder.size()) {
+	// pending CSMs must observe the value the property had when they were
+	// scheduled, as they would in eager mode
+	if (Stale_[id]) {
+		Evaluate(id);
+	}
+	if (FreezeDepth_ == 0 && PlanValid_ && StayOrder_.Front() == id) {
+		// the consumers will be rescheduled by the same plan anyway
+		return;
+	}
+	for (const auto &staleId : StaleIds_) {
+		if (!Stale_[staleId]) {
 			continue;
 		}
-		fulfilledConstraintIds.insert(constraintOrder[newConstraintId]);
+		const auto &inputIds = Producers_[staleId]->GetInputPropertyIds();
+		if (std::ranges::find(inputIds, id) != inputIds.end()) {
+			Evaluate(staleId);
+		}
 	}
+	std::erase_if(StaleIds_, [this](size_t staleId) { return !Stale_[staleId]; });
+}
 
-	for (auto &constraint : Constraints_) {
-		constraint.get().Fulfilled_ = fulfilledConstraintIds.contains(constraint.get().Id_);
+template <typename TModel>
+void TPropertyModel<TModel>::OnPropertySet(size_t id) {
+	if (Evaluating_ || TableRow_) {
+		return;
 	}
+	MarkDirty(id);
+	if (Updating_) {
+		return;
+	};
 
-	Updating_ = false;
-
-	DoCallback();
+	LastSetPropertyId_ = id;
+	size_t previous = StayOrder_.Previous(id);
+	if (StayOrder_.MoveToFront(id)) {
+		// stay order changed, unless the strongest stay is edited again
+		PlanValid_ = false;
+		SaveStayMove(id, previous);
+	}
+	if (FreezeDepth_ > 0) {
+		return;
+	}
+	Update();
 }
 
 template <typename TModel>
-void TPropertyModel<TModel>::DoFreeze() {
-	Freezed_ = true;
+void TPropertyModel<TModel>::OnConstraintBeforeSet(size_t id) {
+	if (!Updating_ && !Evaluating_ && !TableRow_) {
+		// an edit stays open until the update it triggers has finished
+		BeginWrite();
+	}
+	SaveConstraint(id);
 }
 
 template <typename TModel>
-void TPropertyModel<TModel>::DoUnfreeze() {
-	Freezed_ = false;
+void TPropertyModel<TModel>::OnConstraintSet(size_t) {
+	if (Updating_ || TableRow_) {
+		return;
+	};
+
+	PlanValid_ = false;
+	if (FreezeDepth_ > 0) {
+		return;
+	}
 	Update();
 }
 
 template <typename TModel>
-void TPropertyModel<TModel>::DoCallback() {
-	if (!Callback_) {
+void TPropertyModel<TModel>::OnConstraintImportanceSet(size_t id) {
+	if (TableRow_) {
+		return;
+	}
+	if (ConstraintOrderValid_ && !RepositionConstraint(id)) {
+		// the plan only depends on the relative order of constraints, so
+		// nothing updates and the saved importance would otherwise be
+		// committed with the next, unrelated update
+		if (FreezeDepth_ == 0 && !IsSpeculating() && History_) {
+			History_->Step.Clear();
+		}
+		if (FreezeDepth_ == 0 && !Updating_ && !Evaluating_) {
+			EndWrite();
+		}
+		return;
+	}
+
+	OnConstraintSet(id);
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::ConstraintLess(size_t a, size_t b) const {
+	// detached constraints go last
+	auto importance = [this](size_t id) {
+		return Constraints_[id] ? Constraints_[id]->GetImportance() : std::numeric_limits<size_t>::max();
+	};
+	size_t importanceA = importance(a);
+	size_t importanceB = importance(b);
+	return importanceA < importanceB || (importanceA == importanceB && a < b);
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::SortConstraints() {
+	ConstraintOrder_.resize(Constraints_.size());
+	std::iota(ConstraintOrder_.begin(), ConstraintOrder_.end(), 0u);
+	std::ranges::sort(ConstraintOrder_, [this](size_t a, size_t b) { return ConstraintLess(a, b); });
+
+	ConstraintPositions_.resize(Constraints_.size());
+	for (size_t position = 0; position < ConstraintOrder_.size(); ++position) {
+		ConstraintPositions_[ConstraintOrder_[position]] = position;
+	}
+	ConstraintOrderValid_ = true;
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::RepositionConstraint(size_t id) {
+	// only passing another enabled constraint changes the plan
+	bool reordered = false;
+	auto swapWith = [this, &reordered](size_t position, size_t otherPosition) {
+		size_t otherId = ConstraintOrder_[otherPosition];
+		reordered = reordered || IsConstraintEnabled(otherId);
+		std::swap(ConstraintOrder_[position], ConstraintOrder_[otherPosition]);
+		ConstraintPositions_[ConstraintOrder_[position]] = position;
+		ConstraintPositions_[ConstraintOrder_[otherPosition]] = otherPosition;
+	};
+
+	size_t position = ConstraintPositions_[id];
+	while (position > 0 && ConstraintLess(id, ConstraintOrder_[position - 1])) {
+		swapWith(position, position - 1);
+		--position;
+	}
+	while (position + 1 < ConstraintOrder_.size() && ConstraintLess(ConstraintOrder_[position + 1], id)) {
+		swapWith(position, position + 1);
+		++position;
+	}
+
+	return reordered && Constraints_[id]->IsEnabled();
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::Update() {
+	if (Updating_) {
 		return;
 	}
+	{
+		TWriteGuard guard(*this);
+		if (!PlanValid_ && (!AsyncPlanning_ || !PlanInBackground())) {
+			Plan();
+		}
+		Execute();
+		CollectChanges();
+		CommitHistoryStep();
+	}
+
+	DoCallback();
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::Plan() {
+	// producers are about to change
+	FlushStale();
+
+	PlannedCSMs_.clear();
+	PlannedConstraintIds_.clear();
+	if (Callbacks_) {
+		Callbacks_->WasFulfilled.resize(Constraints_.size());
+	}
+	for (size_t id = 0; id < Constraints_.size(); ++id) {
+		if (Constraints_[id]) {
+			if (Callbacks_) {
+				Callbacks_->WasFulfilled[id] = Constraints_[id]->Fulfilled_;
+			}
+			Constraints_[id]->SetFulfilled(false);
+		}
+	}
+
+	if (!PlanPrecomputed()) {
+		PlanWithSolver();
+	}
+
+	if (AsyncPlanning_) {
+		// whatever is still being solved is outdated now
+		AsyncPlanning_->PendingSolution = {};
+		auto &plannedEnabled = AsyncPlanning_->PlannedEnabled;
+		plannedEnabled.resize(Constraints_.size());
+		for (size_t id = 0; id < Constraints_.size(); ++id) {
+			plannedEnabled[id] = IsConstraintEnabled(id);
+		}
+	}
+	StructureChanged_ = false;
+
+	std::ranges::fill(Producers_, nullptr);
+	for (const TCSM<TThis> *csm : PlannedCSMs_) {
+		for (const auto &id : csm->GetOutputPropertyIds()) {
+			Producers_[id] = csm;
+		}
+	}
+
+	// a CSM is one level above the highest producer of its inputs, the
+	// plan is topologically sorted so producers come first
+	auto levelOf = [this](const TCSM<TThis> &csm) {
+		size_t level = 0;
+		for (const auto &id : csm.GetInputPropertyIds()) {
+			level = std::max(level, PropertyLevels_[id]);
+		}
+		return level;
+	};
+	PropertyLevels_.assign(StayOrder_.Size(), 0);
+	LevelBegins_.assign(1, 0);
+	for (const TCSM<TThis> *csm : PlannedCSMs_) {
+		size_t level = levelOf(*csm);
+		for (const auto &id : csm->GetOutputPropertyIds()) {
+			PropertyLevels_[id] = level + 1;
+		}
+		if (LevelBegins_.size() < level + 2) {
+			LevelBegins_.resize(level + 2, 0);
+		}
+		++LevelBegins_[level + 1];
+	}
+	std::partial_sum(LevelBegins_.begin(), LevelBegins_.end(), LevelBegins_.begin());
+	LevelEnds_.assign(LevelBegins_.begin(), LevelBegins_.end() - 1);
+	LeveledCSMs_.resize(PlannedCSMs_.size());
+	for (const TCSM<TThis> *csm : PlannedCSMs_) {
+		LeveledCSMs_[LevelEnds_[levelOf(*csm)]++] = csm;
+	}
+	for (size_t id = 0; Callbacks_ && id < Constraints_.size(); ++id) {
+		if (Constraints_[id] && Callbacks_->WasFulfilled[id] != static_cast<uint8_t>(Constraints_[id]->Fulfilled_)) {
+			Callbacks_->ChangeSet.ConstraintIds.push_back(id);
+		}
+	}
 
-	Callback_();
+	// CSMs that were not part of the previous plan have never produced
+	// their outputs, marking those dirty executes them and everything that
+	// depends on them
+	PlanChanged_ = false;
+	for (size_t index = 0; index < PlannedCSMs_.size(); ++index) {
+		size_t constraintId = PlannedConstraintIds_[index];
+		auto csmIndex = static_cast<size_t>(PlannedCSMs_[index] - Constraints_[constraintId]->GetCSMs().data());
+		if (SelectedCSMs_[constraintId] == csmIndex) {
+			continue;
+		}
+		PlanChanged_ = true;
+		for (const auto &id : PlannedCSMs_[index]->GetOutputPropertyIds()) {
+			MarkDirty(id);
+		}
+	}
+	std::ranges::fill(SelectedCSMs_, TStayOrder::NONE);
+	for (size_t index = 0; index < PlannedCSMs_.size(); ++index) {
+		SelectedCSMs_[PlannedConstraintIds_[index]] = PlannedCSMs_[index] - Constraints_[PlannedConstraintIds_[index]]->GetCSMs().data();
+	}
+
+	PlanValid_ = true;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::PlanWithSolver() {
+	BuildPlanSignature();
+	TSolverState &state = *SolverState_;
+
+	const NSolver::TSolution *cached = state.PlanCache.Find(state.PlanSignature);
+	std::optional<NSolver::TSolution> awaited;
+	if (!cached && IsPlanPending() && AsyncPlanning_->PendingSignature == state.PlanSignature) {
+		awaited = std::exchange(AsyncPlanning_->PendingSolution, {}).get();
+		if (!awaited) {
+			throw std::logic_error("Property model is to complex to be resolved.");
+		}
+		state.PlanCache.Insert(state.PlanSignature, *awaited);
+		cached = &*awaited;
+	}
+
+	BuildTask(!cached);
+
+	if (cached) {
+		state.Solution.CSMIds.assign(cached->CSMIds.begin(), cached->CSMIds.end());
+	} else {
+		auto maybeSolution = NSolver::SolveByComponents(state.Solver, state.Task, state.ComponentKeys, state.ComponentCache, COMPONENT_CACHE_CAPACITY);
+
+		if (!maybeSolution) {
+			throw std::logic_error("Property model is to complex to be resolved.");
+		}
+		state.Solution = std::move(maybeSolution.value());
+		state.PlanCache.Insert(state.PlanSignature, state.Solution);
+	}
+
+	for (const auto &csmId : state.Solution.CSMIds) {
+		if (const TCSM<TThis> *csm = state.BackPointers[csmId]) {
+			PlannedCSMs_.push_back(csm);
+			PlannedConstraintIds_.push_back(state.BackConstraintIds[csmId]);
+		}
+
+		size_t constraintId = state.BackConstraintIds[csmId];
+		if (constraintId < Constraints_.size()) {
+			Constraints_[constraintId]->SetFulfilled(true);
+		}
+	}
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::PlanInBackground() {
+	// speculations need their results and are rolled back to the old plan
+	const auto &plannedEnabled = AsyncPlanning_->PlannedEnabled;
+	if (PrecomputedPlans_ || StructureChanged_ || IsSpeculating() || plannedEnabled.size() != Constraints_.size()) {
+		return false;
+	}
+	for (size_t id = 0; id < Constraints_.size(); ++id) {
+		if (plannedEnabled[id] != static_cast<uint8_t>(IsConstraintEnabled(id))) {
+			return false;
+		}
+	}
+	for (const auto &id : DirtyIds_) {
+		if (Producers_[id]) {
+			// the previous plan would overwrite the edit
+			return false;
+		}
+	}
+
+	BuildPlanSignature();
+	TSolverState &state = *SolverState_;
+	TAsyncPlanning &async = *AsyncPlanning_;
+	if (state.PlanCache.Contains(state.PlanSignature)) {
+		return false;
+	}
+	if (async.PendingSolution.valid() && async.PendingSignature == state.PlanSignature) {
+		// installed by Plan once it is ready
+		return async.PendingSolution.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+	}
+
+	BuildTask(true);
+	async.PendingSignature = state.PlanSignature;
+	async.PendingSolution = async.Solver.Submit(state.Task);
+	return true;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::BuildPlanSignature() {
+	if (!ConstraintOrderValid_) {
+		SortConstraints();
+	}
+
+	auto &signature = GetSolverState().PlanSignature;
+	signature.clear();
+	for (const auto &constraintId : ConstraintOrder_) {
+		signature.push_back((constraintId << 1u) | static_cast<size_t>(IsConstraintEnabled(constraintId)));
+	}
+	signature.insert(signature.end(), StayOrder_.begin(), StayOrder_.end());
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::BuildTask(bool withTask) {
+	// the task is only needed by the solver; its storage is reused between
+	// plans so that rebuilding it does not allocate
+	TSolverState &state = *SolverState_;
+	size_t taskSize = 0;
+	auto nextTaskCSM = [&state, &taskSize]() -> NSolver::TCSM & {
+		if (state.Task.CSMs.size() <= taskSize) {
+			state.Task.CSMs.emplace_back();
+		}
+		return state.Task.CSMs[taskSize++];
+	};
+
+	state.BackPointers.clear();
+	state.BackConstraintIds.clear();
+	if (withTask) {
+		state.ComponentKeys.assign(Constraints_.size() + StayOrder_.Size(), 0);
+	}
+
+	for (size_t constraintNewId = 0; constraintNewId < ConstraintOrder_.size(); ++constraintNewId) {
+		if (!IsConstraintEnabled(ConstraintOrder_[constraintNewId])) {
+			continue;
+		}
+		auto &constraint = *Constraints_[ConstraintOrder_[constraintNewId]];
+		if (withTask) {
+			state.ComponentKeys[constraintNewId] = ConstraintSerials_[constraint.Id_] << 1u;
+		}
+
+		for (auto &csm : constraint.GetCSMs()) {
+			if (withTask) {
+				NSolver::TCSM &taskCSM = nextTaskCSM();
+				taskCSM.ConstraintId = constraintNewId;
+				taskCSM.InputPropertyIds.assign(csm.GetInputPropertyIds().begin(), csm.GetInputPropertyIds().end());
+				taskCSM.OutputPropertyIds.assign(csm.GetOutputPropertyIds().begin(), csm.GetOutputPropertyIds().end());
+			}
+			state.BackPointers.push_back(&csm);
+			state.BackConstraintIds.push_back(constraint.Id_);
+		}
+	}
+
+	size_t stayConstraintId = Constraints_.size();
+	for (const auto propertyId : StayOrder_) {
+		if (withTask) {
+			state.ComponentKeys[stayConstraintId] = (propertyId << 1u) | 1u;
+			NSolver::TCSM &taskCSM = nextTaskCSM();
+			taskCSM.ConstraintId = stayConstraintId++;
+			taskCSM.InputPropertyIds.clear();
+			taskCSM.OutputPropertyIds.assign(1, propertyId);
+		}
+		state.BackPointers.push_back(nullptr);
+		state.BackConstraintIds.push_back(Constraints_.size());
+	}
+
+	if (withTask) {
+		state.Task.PropertiesCount = StayOrder_.Size();
+		state.Task.ConstraintsCount = Constraints_.size() + StayOrder_.Size();
+		state.Task.CSMs.resize(taskSize);
+	}
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::PlanPrecomputed() {
+	if (!PrecomputedPlans_ || Restructured_) {
+		return false;
+	}
+
+	TPrecomputedPlans &plans = GetPrecomputedPlans();
+	for (size_t id = 0; id < Constraints_.size(); ++id) {
+		const auto &constraint = *Constraints_[id];
+		if (constraint.IsEnabled() != plans.Enabled[id] || constraint.GetImportance() != plans.Importances[id]) {
+			return false;
+		}
+	}
+
+	// the plan depends on the whole stay order, not only on its front
+	const TPrecomputedPlan *plan = nullptr;
+	{
+		std::shared_lock lock(plans.Mutex);
+		if (auto found = plans.ByStayOrder.find(StayOrder_); found != plans.ByStayOrder.end()) {
+			plan = &found->second;
+		}
+	}
+	if (!plan) {
+		std::unique_lock lock(plans.Mutex);
+		if (auto found = plans.ByStayOrder.find(StayOrder_); found != plans.ByStayOrder.end()) {
+			plan = &found->second;
+		} else if (plans.ByStayOrder.size() < PRECOMPUTED_PLANS_CAPACITY) {
+			plan = &SolvePrecomputedPlan(plans, std::vector<size_t>(StayOrder_.begin(), StayOrder_.end()));
+		} else {
+			return false;
+		}
+	}
+
+	for (const auto &[constraintId, csmIndex] : plan->CSMs) {
+		PlannedCSMs_.push_back(&Constraints_[constraintId]->GetCSMs()[csmIndex]);
+		PlannedConstraintIds_.push_back(constraintId);
+	}
+	for (const auto &constraintId : plan->FulfilledConstraintIds) {
+		Constraints_[constraintId]->SetFulfilled(true);
+	}
+	return true;
+}
+
+template <typename TModel>
+typename TPropertyModel<TModel>::TPrecomputedPlans &TPropertyModel<TModel>::GetPrecomputedPlans() {
+	// the graph is the same for every instance of the model type
+	static TPrecomputedPlans plans;
+	static std::once_flag built;
+	std::call_once(built, [this]() { BuildPrecomputedPlans(plans); });
+	return plans;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::BuildPrecomputedPlans(TPrecomputedPlans &plans) const {
+	const size_t propertiesCount = StayOrder_.Size();
+	const size_t constraintsCount = Constraints_.size();
+
+	std::vector<size_t> constraintOrder(constraintsCount);
+	std::iota(constraintOrder.begin(), constraintOrder.end(), 0u);
+	std::ranges::stable_sort(constraintOrder, [this](size_t a, size_t b) {
+		return Constraints_[a]->GetImportance() < Constraints_[b]->GetImportance();
+	});
+	for (const auto &constraint : Constraints_) {
+		plans.Enabled.push_back(constraint->IsEnabled());
+		plans.Importances.push_back(constraint->GetImportance());
+	}
+
+	plans.Task = {
+	    .PropertiesCount = propertiesCount,
+	    .ConstraintsCount = constraintsCount + propertiesCount,
+	    .CSMs{},
+	};
+	for (size_t constraintNewId = 0; constraintNewId < constraintsCount; ++constraintNewId) {
+		size_t constraintId = constraintOrder[constraintNewId];
+		auto &constraint = *Constraints_[constraintId];
+		if (!constraint.IsEnabled()) {
+			continue;
+		}
+
+		auto &csms = constraint.GetCSMs();
+		for (size_t csmIndex = 0; csmIndex < csms.size(); ++csmIndex) {
+			plans.Task.CSMs.emplace_back(
+			    constraintNewId,
+			    csms[csmIndex].GetInputPropertyIds(),
+			    csms[csmIndex].GetOutputPropertyIds()
+			);
+			plans.BackReferences.emplace_back(constraintId, csmIndex);
+		}
+	}
+	for (size_t stayConstraintId = 0; stayConstraintId < propertiesCount; ++stayConstraintId) {
+		plans.Task.CSMs.emplace_back(
+		    constraintsCount + stayConstraintId,
+		    std::vector<size_t>{},
+		    std::vector<size_t>{0}
+		);
+	}
+
+	std::vector<size_t> stayOrder;
+	for (size_t editedId = 0; editedId <= propertiesCount; ++editedId) {
+		// the edited property is the strongest stay, the rest follow in
+		// declaration order; no edited property is the order before any edit
+		stayOrder.clear();
+		if (editedId < propertiesCount) {
+			stayOrder.push_back(editedId);
+		}
+		for (size_t propertyId = 0; propertyId < propertiesCount; ++propertyId) {
+			if (propertyId != editedId) {
+				stayOrder.push_back(propertyId);
+			}
+		}
+		if (!plans.ByStayOrder.contains(stayOrder)) {
+			SolvePrecomputedPlan(plans, stayOrder);
+		}
+	}
+}
+
+template <typename TModel>
+const typename TPropertyModel<TModel>::TPrecomputedPlan &TPropertyModel<TModel>::SolvePrecomputedPlan(
+    TPrecomputedPlans &plans,
+    const std::vector<size_t> &stayOrder
+) {
+	const size_t staysBegin = plans.BackReferences.size();
+	for (size_t stay = 0; stay < stayOrder.size(); ++stay) {
+		plans.Task.CSMs[staysBegin + stay].OutputPropertyIds[0] = stayOrder[stay];
+	}
+
+	auto maybeSolution = NSolver::GetSolver().TrySolve(plans.Task);
+	if (!maybeSolution) {
+		throw std::logic_error("Property model is to complex to be resolved.");
+	}
+
+	TPrecomputedPlan plan;
+	for (const auto &csmId : maybeSolution->CSMIds) {
+		if (csmId >= staysBegin) {
+			continue;
+		}
+		plan.CSMs.push_back(plans.BackReferences[csmId]);
+		plan.FulfilledConstraintIds.push_back(plans.BackReferences[csmId].first);
+	}
+	return plans.ByStayOrder.emplace(stayOrder, std::move(plan)).first->second;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::Execute() {
+	// levels are visited in order, so a single pass visits every CSM
+	// downstream of the dirty properties; outputs are marked dirty by the
+	// CSMs writing them
+	if (!Lazy_) {
+		for (size_t level = 0; level + 1 < LevelBegins_.size(); ++level) {
+			ExecuteLevel(LevelBegins_[level], LevelBegins_[level + 1]);
+		}
+		FullExecution_ = false;
+		PlanChanged_ = false;
+		return;
+	}
+
+	for (const TCSM<TThis> *csm : PlannedCSMs_) {
+		if (!FullExecution_ && !IsAffected(*csm)) {
+			continue;
+		}
+
+		for (const auto &id : csm->GetOutputPropertyIds()) {
+			MarkDirty(id);
+			if (!Stale_[id]) {
+				Stale_[id] = 1;
+				StaleIds_.push_back(id);
+			}
+		}
+	}
+	FullExecution_ = false;
+	PlanChanged_ = false;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::ExecuteLevel(size_t begin, size_t end) {
+	// CSMs of one level do not read each other's outputs, so all of them can
+	// be checked before any of them runs
+	Batch_.clear();
+	for (size_t index = begin; index < end; ++index) {
+		const TCSM<TThis> *csm = LeveledCSMs_[index];
+		if (FullExecution_ || IsAffected(*csm)) {
+			Batch_.push_back(csm);
+		}
+	}
+	if (Batch_.empty()) {
+		return;
+	}
+	++ExecutionStats_.Levels;
+	ExecutionStats_.ExecutedCSMs += Batch_.size();
+
+	// CSMs save the values they overwrite to the undo log or the history,
+	// which are not shared between threads
+	if (!ParallelExecution_ || Batch_.size() < ParallelExecution_->Threshold || IsSpeculating() || IsRecordingHistory()) {
+		for (const TCSM<TThis> *csm : Batch_) {
+			csm->Apply(static_cast<TThis &>(*this));
+		}
+		return;
+	}
+	++ExecutionStats_.ParallelLevels;
+	ExecutionStats_.ParallelCSMs += Batch_.size();
+
+	auto listOutputs = [this]() {
+		ExecutingParallel_ = false;
+		for (const TCSM<TThis> *csm : Batch_) {
+			for (const auto &id : csm->GetOutputPropertyIds()) {
+				ListDirty(id);
+			}
+		}
+	};
+	ExecutingParallel_ = true;
+	try {
+		ParallelExecution_->ThreadPool.Run(Batch_.size(), [this](size_t index) { Batch_[index]->Apply(static_cast<TThis &>(*this)); });
+	} catch (...) {
+		listOutputs();
+		throw;
+	}
+	listOutputs();
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::CollectRowCSMs(std::vector<const TCSM<TThis> *> &csms) {
+	// same as Execute, but the CSMs are applied to the rows of a table by
+	// the caller; returns whether all rows have to run them
+	if (!PlanValid_) {
+		Plan();
+	}
+	if (Callbacks_) {
+		Callbacks_->ChangeSet.ConstraintIds.clear();
+	}
+	// newly selected CSMs have never run on any row
+	bool allRows = FullExecution_ || PlanChanged_;
+
+	csms.clear();
+	for (const TCSM<TThis> *csm : PlannedCSMs_) {
+		if (!FullExecution_ && !IsAffected(*csm)) {
+			continue;
+		}
+
+		for (const auto &id : csm->GetOutputPropertyIds()) {
+			MarkDirty(id);
+		}
+		csms.push_back(csm);
+	}
+	FullExecution_ = false;
+	PlanChanged_ = false;
+
+	for (const auto &id : DirtyIds_) {
+		Dirty_[id] = 0;
+	}
+	DirtyIds_.clear();
+	return allRows;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::MakeTableRow() {
+	TableRow_ = true;
+	for (const auto &id : DirtyIds_) {
+		Dirty_[id] = 0;
+	}
+	DirtyIds_.clear();
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::MarkDirty(size_t id) {
+	if (Dirty_[id]) {
+		return;
+	}
+	if (ExecutingParallel_) {
+		// each property is written by a single CSM, but the list is shared
+		Dirty_[id] = 2;
+		return;
+	}
+	Dirty_[id] = 1;
+	DirtyIds_.push_back(id);
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::ListDirty(size_t id) {
+	if (Dirty_[id] != 2) {
+		return;
+	}
+	Dirty_[id] = 1;
+	DirtyIds_.push_back(id);
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::Evaluate(size_t id) {
+	const TCSM<TThis> &csm = *Producers_[id];
+	for (const auto &outputId : csm.GetOutputPropertyIds()) {
+		Stale_[outputId] = 0;
+	}
+	for (const auto &inputId : csm.GetInputPropertyIds()) {
+		if (Stale_[inputId]) {
+			Evaluate(inputId);
+		}
+	}
+
+	bool evaluating = std::exchange(Evaluating_, true);
+	csm.Apply(static_cast<TThis &>(*this));
+	Evaluating_ = evaluating;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::FlushStale() {
+	for (const auto &id : StaleIds_) {
+		if (Stale_[id]) {
+			Evaluate(id);
+		}
+	}
+	StaleIds_.clear();
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::IsAffected(const TCSM<TThis> &csm) const {
+	// a dirty output means the user overwrote a derived value, which has to
+	// be restored by its CSM
+	for (const auto &id : csm.GetInputPropertyIds()) {
+		if (Dirty_[id]) {
+			return true;
+		}
+	}
+	for (const auto &id : csm.GetOutputPropertyIds()) {
+		if (Dirty_[id]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::BeginWrite() {
+	uint64_t version = Version_.load(std::memory_order_relaxed);
+	if (version % 2 == 1) {
+		return;
+	}
+	Version_.store(version + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::EndWrite() {
+	uint64_t version = Version_.load(std::memory_order_relaxed);
+	if (version % 2 == 0) {
+		return;
+	}
+	Version_.store(version + 1, std::memory_order_release);
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::DoFreeze() {
+	++FreezeDepth_;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::DoUnfreeze() {
+	if (--FreezeDepth_ > 0) {
+		return;
+	}
+	// all edits made while frozen are planned and executed at once
+	Update();
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::DoSpeculate() {
+	if (FreezeDepth_ > 0 || Updating_) {
+		throw std::logic_error("Property model can not speculate while frozen or updating.");
+	}
+	// stale values are computed from the state the speculation starts with
+	FlushStale();
+
+	if (!Speculation_) {
+		Speculation_ = std::make_unique<TSpeculation>();
+		Speculation_->UndoDepths.resize(Dirty_.size(), 0);
+	}
+	TUndoLog &log = Speculation_->UndoLog;
+	Speculation_->Begins.push_back({log.Entries.size(), log.Values.GetMark()});
+	log.Entries.push_back(TSavedLastSet{LastSetPropertyId_});
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::DoRollback() {
+	// stale values depend on speculative inputs, restored values do not
+	for (const auto &id : StaleIds_) {
+		Stale_[id] = 0;
+	}
+	StaleIds_.clear();
+
+	BeginWrite();
+	TSpeculation &speculation = *Speculation_;
+	TUndoLog &log = speculation.UndoLog;
+	const TSpeculationBegin begin = speculation.Begins.back();
+	for (size_t index = log.Entries.size(); index-- > begin.Entry;) {
+		TUndoEntry &entry = log.Entries[index];
+		ApplyUndoEntry(entry);
+		if (const auto *value = std::get_if<TSavedValue>(&entry)) {
+			speculation.UndoDepths[value->PropertyId] = value->PreviousDepth;
+		}
+	}
+	log.Entries.resize(begin.Entry);
+	log.Values.Rollback(begin.Values);
+
+	// the restored values satisfy the plan the speculation started with, so
+	// replanning finds it in the cache and only reruns CSMs it selects
+	// differently, which recompute the same values
+	ConstraintOrderValid_ = false;
+	PlanValid_ = false;
+	Update();
+
+	speculation.Begins.pop_back();
+	size_t depth = speculation.Begins.size();
+	// values written by the replan belong to the enclosing speculation
+	for (size_t index = begin.Entry; index < log.Entries.size(); ++index) {
+		if (const auto *value = std::get_if<TSavedValue>(&log.Entries[index])) {
+			speculation.UndoDepths[value->PropertyId] = depth;
+		}
+	}
+	if (depth == 0) {
+		log.Clear();
+	}
+}
+
+template <typename TModel>
+template <typename TValue>
+void TPropertyModel<TModel>::SaveProperty(size_t id, TValue &value) {
+	TUndoLog *log = nullptr;
+	size_t previousDepth = 0;
+	if (IsSpeculating()) {
+		size_t depth = Speculation_->Begins.size();
+		if (Speculation_->UndoDepths[id] >= depth) {
+			return;
+		}
+		log = &Speculation_->UndoLog;
+		previousDepth = std::exchange(Speculation_->UndoDepths[id], depth);
+	} else {
+		if (!IsRecordingHistory() || History_->Serials[id] == History_->Serial) {
+			return;
+		}
+		OpenHistoryStep();
+		log = &History_->Step;
+		History_->Serials[id] = History_->Serial;
+	}
+	log->Entries.push_back(TSavedValue{
+	    .PropertyId = id,
+	    .PreviousDepth = previousDepth,
+	    .Value = &value,
+	    .Saved = log->Values.Save(value),
+	    .Swap =
+	        [](void *value, void *saved) {
+		        auto &property = *static_cast<TValue *>(value);
+		        auto &savedValue = *static_cast<TValue *>(saved);
+		        if constexpr (IsSnapshotValue<TValue>()) {
+			        // snapshot readers may load the property meanwhile
+			        savedValue = std::atomic_ref<TValue>(property).exchange(savedValue, std::memory_order_relaxed);
+		        } else {
+			        std::swap(property, savedValue);
+		        }
+	        },
+	});
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::SaveConstraint(size_t id) {
+	TUndoLog *log = GetUndoLog();
+	if (!log) {
+		return;
+	}
+	const TConstraint<TThis> &constraint = *Constraints_[id];
+	log->Entries.push_back(TSavedConstraint{
+	    .ConstraintId = id,
+	    .Enabled = constraint.Enabled_,
+	    .Importance = constraint.Importance_,
+	});
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::SaveStayMove(size_t id, size_t previous) {
+	TUndoLog *log = GetUndoLog();
+	if (!log) {
+		return;
+	}
+	log->Entries.push_back(TSavedStayMove{.PropertyId = id, .Previous = previous, .Undone = false});
+}
+
+template <typename TModel>
+typename TPropertyModel<TModel>::TUndoLog *TPropertyModel<TModel>::GetUndoLog() {
+	if (IsSpeculating()) {
+		return &Speculation_->UndoLog;
+	}
+	if (!IsRecordingHistory()) {
+		return nullptr;
+	}
+	OpenHistoryStep();
+	return &History_->Step;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::ApplyUndoEntry(TUndoEntry &entry) {
+	if (auto *value = std::get_if<TSavedValue>(&entry)) {
+		value->Swap(value->Value, value->Saved);
+	} else if (auto *constraint = std::get_if<TSavedConstraint>(&entry)) {
+		auto &target = *Constraints_[constraint->ConstraintId];
+		bool enabled = target.Enabled_;
+		target.SetEnabled(constraint->Enabled);
+		constraint->Enabled = enabled;
+		std::swap(target.Importance_, constraint->Importance);
+	} else if (auto *move = std::get_if<TSavedStayMove>(&entry)) {
+		// entries are undone in reverse and redone in recording order, so
+		// the neighbours are the same as when the move was made
+		if (move->Undone) {
+			StayOrder_.MoveToFront(move->PropertyId);
+		} else {
+			StayOrder_.MoveAfter(move->PropertyId, move->Previous);
+		}
+		move->Undone = !move->Undone;
+	} else {
+		std::swap(LastSetPropertyId_, std::get<TSavedLastSet>(entry).PropertyId);
+	}
+}
+
+template <typename TModel>
+bool TPropertyModel<TModel>::IsRecordingHistory() const {
+	return History_ && !Lazy_;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::OpenHistoryStep() {
+	if (!History_->Step.Entries.empty()) {
+		return;
+	}
+	History_->Step.Entries.push_back(TSavedLastSet{LastSetPropertyId_});
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::CommitHistoryStep() {
+	if (!History_ || History_->Step.Entries.empty()) {
+		return;
+	}
+	THistory &history = *History_;
+	// a new edit discards the steps that could be redone
+	history.Count = history.Position;
+	if (history.Count == history.Slots.size()) {
+		history.First = (history.First + 1) % history.Slots.size();
+		--history.Count;
+	}
+	auto &slot = history.Slots[(history.First + history.Count) % history.Slots.size()];
+	slot.Swap(history.Step);
+	history.Step.Clear();
+	history.Position = ++history.Count;
+	++history.Serial;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::ClearHistory() {
+	if (!History_) {
+		return;
+	}
+	THistory &history = *History_;
+	for (auto &slot : history.Slots) {
+		slot.Clear();
+	}
+	history.Step.Clear();
+	history.First = 0;
+	history.Count = 0;
+	history.Position = 0;
+	++history.Serial;
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::ApplyHistoryStep(size_t slot, bool undo) {
+	if (FreezeDepth_ > 0 || Updating_ || IsSpeculating()) {
+		throw std::logic_error("Property model can not undo or redo while frozen, updating or speculating.");
+	}
+	std::optional<TWriteGuard> guard(std::in_place, *this);
+
+	auto &entries = History_->Slots[slot].Entries;
+	// the first entry restores the last edited property
+	bool replan = false;
+	auto apply = [this, &replan](TUndoEntry &entry) {
+		ApplyUndoEntry(entry);
+		if (const auto *value = std::get_if<TSavedValue>(&entry)) {
+			if (Callbacks_) {
+				Callbacks_->ChangeSet.PropertyIds.push_back(value->PropertyId);
+			}
+		} else {
+			replan = true;
+		}
+	};
+	if (undo) {
+		for (size_t index = entries.size(); index-- > 1;) {
+			apply(entries[index]);
+		}
+	} else {
+		for (size_t index = 1; index < entries.size(); ++index) {
+			apply(entries[index]);
+		}
+	}
+	ApplyUndoEntry(entries[0]);
+
+	if (replan) {
+		// the restored values were computed by the plan that is found now,
+		// no CSM has to run again
+		ConstraintOrderValid_ = false;
+		PlanValid_ = false;
+		Plan();
+		for (const auto &id : DirtyIds_) {
+			Dirty_[id] = 0;
+		}
+		DirtyIds_.clear();
+		PlanChanged_ = false;
+	}
+
+	guard.reset();
+	DoCallback();
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::CollectChanges() {
+	// with early cutoff the dirty set is exactly the set of changed values;
+	// in lazy mode it also holds stale outputs that may turn out unchanged
+	for (const auto &id : DirtyIds_) {
+		Dirty_[id] = 0;
+		// detached properties are not reported
+		if (Callbacks_ && StayOrder_.Contains(id)) {
+			Callbacks_->ChangeSet.PropertyIds.push_back(id);
+		}
+	}
+	DirtyIds_.clear();
+}
+
+template <typename TModel>
+void TPropertyModel<TModel>::DoCallback() {
+	if (!Callbacks_) {
+		return;
+	}
+	TCallbacks &callbacks = *Callbacks_;
+	if (IsSpeculating()) {
+		callbacks.ChangeSet.PropertyIds.clear();
+		callbacks.ChangeSet.ConstraintIds.clear();
+		return;
+	}
+
+	// callbacks may edit the model and start a nested update, which has to
+	// collect its own changes
+	TChangeSet changes;
+	std::swap(changes, callbacks.ChangeSet);
+
+	if (callbacks.Model) {
+		callbacks.Model();
+	}
+	if (callbacks.Changes && (!changes.PropertyIds.empty() || !changes.ConstraintIds.empty())) {
+		callbacks.Changes(changes);
+	}
+	for (const auto &id : changes.PropertyIds) {
+		if (callbacks.Properties[id]) {
+			callbacks.Properties[id]();
+		}
+	}
+	for (const auto &id : changes.ConstraintIds) {
+		if (callbacks.Constraints[id]) {
+			callbacks.Constraints[id]();
+		}
+	}
+
+	if (callbacks.ChangeSet.PropertyIds.empty() && callbacks.ChangeSet.ConstraintIds.empty()) {
+		// keep the storage for the next update
+		changes.PropertyIds.clear();
+		changes.ConstraintIds.clear();
+		std::swap(changes, callbacks.ChangeSet);
+	}
+}
+
+template <typename TModel>
+typename TPropertyModel<TModel>::TCallbacks &TPropertyModel<TModel>::GetCallbacks() {
+	if (!Callbacks_) {
+		// changes are collected from now on
+		Callbacks_ = std::make_unique<TCallbacks>();
+		Callbacks_->Properties.resize(Dirty_.size());
+		Callbacks_->Constraints.resize(Constraints_.size());
+	}
+	return *Callbacks_;
+}
+
+template <typename TModel>
+typename TPropertyModel<TModel>::TSolverState &TPropertyModel<TModel>::GetSolverState() {
+	if (!SolverState_) {
+		SolverState_ = std::make_unique<TSolverState>();
+	}
+	return *SolverState_;
 }
 
 }  // namespace NPropertyModels
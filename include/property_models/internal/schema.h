@@ -0,0 +1,90 @@
+#pragma once
+
+#ifndef NPROPERTY_MODELS_IMPL_ALLOWED
+#error "This header may not be included directly. Please include \"property_models/model.h\" instead"
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "column.h"
+#include "csm.h"
+
+namespace NPropertyModels {
+
+// Structure shared by all instances of a model type. The CSMs of declared
+// constraints are the same for every instance, since they only hold
+// property ids and a function of the model, so they are built by the first
+// instance and referenced by all later ones.
+//
+// Declared properties are described by their type and their place in the
+// model, which is what a model table needs to store them in columns.
+//
+// Only the CSMs live here. Properties and constraints still keep a reference
+// to their model and their id: a write to a property member has to reach
+// its model, and members attached at runtime are not part of the type.
+// Entries are looked up by those ids, which declared members get in
+// declaration order, so they agree between instances.
+template <typename TModel>
+class TSchema {
+public:
+	static TSchema &Get() {
+		static TSchema schema;
+		return schema;
+	}
+
+	// returns the CSMs of the declared constraint, makeCSMs are only called
+	// the first time
+	template <typename... TMakeCSM>
+	const std::vector<TCSM<TModel>> &GetCSMs(size_t constraintId, TMakeCSM &&...makeCSMs) {
+		std::lock_guard lock(Mutex_);
+		if (Constraints_.size() <= constraintId) {
+			Constraints_.resize(constraintId + 1);
+		}
+		auto &csms = Constraints_[constraintId];
+		if (!csms) {
+			csms.emplace();
+			csms->reserve(sizeof...(makeCSMs));
+			(csms->push_back(makeCSMs()), ...);
+		}
+		return *csms;
+	}
+
+	// describes the declared property, only the first time
+	template <typename TValue>
+	void AddProperty(size_t propertyId, size_t offset) {
+		if (propertyId < PropertiesCount_.load(std::memory_order_acquire)) {
+			return;
+		}
+		std::lock_guard lock(Mutex_);
+		if (Properties_.size() <= propertyId) {
+			Properties_.resize(propertyId + 1);
+		}
+		Properties_[propertyId] = {
+		    .Offset = offset,
+		    .MakeColumn = &TTypedColumn<TValue, TModel>::Make,
+		};
+		PropertiesCount_.store(Properties_.size(), std::memory_order_release);
+	}
+
+	[[nodiscard]] std::vector<TPropertyType<TModel>> GetProperties() {
+		std::lock_guard lock(Mutex_);
+		return Properties_;
+	}
+
+private:
+	TSchema() = default;
+
+private:
+	std::mutex Mutex_;
+	// references stay valid while constraints are added
+	std::deque<std::optional<std::vector<TCSM<TModel>>>> Constraints_;
+	std::vector<TPropertyType<TModel>> Properties_;
+	std::atomic<size_t> PropertiesCount_ = 0;
+};
+
+}  // namespace NPropertyModels
@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef NPROPERTY_MODELS_IMPL_ALLOWED
+#error "This header may not be included directly. Please include \"property_models/model.h\" instead"
+#endif
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "solver.h"
+
+namespace NPropertyModels::NSolver {
+
+using TSolutionFuture = std::shared_future<std::optional<TSolution>>;
+
+// Solves tasks one at a time on a dedicated thread. Only the most recent
+// task waits in the queue: submitting replaces a task that has not been
+// started yet, whose future is then abandoned.
+class TAsyncSolver {
+public:
+	explicit TAsyncSolver(TSolver solver = GetSolver());
+	TAsyncSolver(const TAsyncSolver &) = delete;
+	TAsyncSolver(TAsyncSolver &&) = delete;
+	TAsyncSolver &operator=(const TAsyncSolver &) = delete;
+	TAsyncSolver &operator=(TAsyncSolver &&) = delete;
+	~TAsyncSolver();
+
+	[[nodiscard]] TSolutionFuture Submit(TTask task);
+
+private:
+	void Run();
+
+private:
+	TSolver Solver_;
+	std::mutex Mutex_;
+	std::condition_variable Condition_;
+	std::optional<std::pair<TTask, std::promise<std::optional<TSolution>>>> Queued_;
+	bool Stopping_ = false;
+	std::thread Thread_;
+};
+
+}  // namespace NPropertyModels::NSolver
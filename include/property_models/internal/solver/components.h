@@ -0,0 +1,36 @@
+#pragma once
+
+#ifndef NPROPERTY_MODELS_IMPL_ALLOWED
+#error "This header may not be included directly. Please include \"property_models/model.h\" instead"
+#endif
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "plan_cache.h"
+#include "solver.h"
+
+namespace NPropertyModels::NSolver {
+
+// Splits the task into components, groups of constraints connected through
+// shared properties, and solves each of them on its own. Components are
+// looked up in the cache by the keys of their constraints in priority
+// order, so after a local change only the components containing it are
+// solved again.
+//
+// constraintKeys[constraintId] has to identify the constraint together with
+// its CSMs, e.g. never reuse the key of a constraint with other CSMs.
+//
+// The capacity of the cache is set to twice the number of components, but
+// not below minCapacity, so it follows the structure as it grows and
+// shrinks.
+[[nodiscard]] std::optional<TSolution> SolveByComponents(
+    const TSolver &solver,
+    const TTask &task,
+    const std::vector<size_t> &constraintKeys,
+    TPlanCache &cache,
+    size_t minCapacity
+);
+
+}  // namespace NPropertyModels::NSolver
@@ -0,0 +1,65 @@
+#pragma once
+
+#ifndef NPROPERTY_MODELS_IMPL_ALLOWED
+#error "This header may not be included directly. Please include \"property_models/model.h\" instead"
+#endif
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "solver.h"
+
+namespace NPropertyModels::NSolver {
+
+// Encodes everything a task depends on: constraint order with enabled
+// flags followed by the stay order of properties.
+using TPlanSignature = std::vector<size_t>;
+
+struct TPlanSignatureHash {
+	[[nodiscard]] size_t operator()(const TPlanSignature &signature) const;
+};
+
+struct TPlanCacheStats {
+	size_t Hits = 0;
+	size_t Misses = 0;
+	size_t Size = 0;
+	size_t Capacity = 0;
+};
+
+class TPlanCache {
+public:
+	static constexpr size_t DEFAULT_CAPACITY = 16;
+
+	explicit TPlanCache(size_t capacity = DEFAULT_CAPACITY);
+
+	// returns nullptr on miss, otherwise marks the entry as most recently used
+	[[nodiscard]] const TSolution *Find(const TPlanSignature &signature);
+
+	// does not count as a hit or a miss
+	[[nodiscard]] bool Contains(const TPlanSignature &signature) const;
+
+	void Insert(const TPlanSignature &signature, const TSolution &solution);
+
+	void SetCapacity(size_t capacity);
+
+	void Clear();
+
+	[[nodiscard]] TPlanCacheStats GetStats() const;
+
+private:
+	using TEntries = std::list<std::pair<TPlanSignature, TSolution>>;
+
+	void Shrink();
+
+private:
+	size_t Capacity_;
+	size_t Hits_ = 0;
+	size_t Misses_ = 0;
+	TEntries Entries_;
+	std::unordered_map<TPlanSignature, TEntries::iterator, TPlanSignatureHash> Index_;
+};
+
+}  // namespace NPropertyModels::NSolver
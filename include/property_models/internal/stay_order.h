@@ -0,0 +1,184 @@
+#pragma once
+
+#ifndef NPROPERTY_MODELS_IMPL_ALLOWED
+#error "This header may not be included directly. Please include \"property_models/model.h\" instead"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace NPropertyModels {
+
+// Properties ordered from the most to the least recently edited, kept as an
+// intrusive doubly linked list so that an edit is an O(1) move to front.
+class TStayOrder {
+public:
+	static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+	class TIterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = size_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const size_t *;
+		using reference = size_t;
+
+		TIterator() = default;
+
+		size_t operator*() const {
+			return Id_;
+		}
+
+		TIterator &operator++() {
+			Id_ = (*Next_)[Id_];
+			return *this;
+		}
+
+		TIterator operator++(int) {
+			TIterator result = *this;
+			++*this;
+			return result;
+		}
+
+		bool operator==(const TIterator &other) const {
+			return Id_ == other.Id_;
+		}
+
+	private:
+		friend TStayOrder;
+
+		TIterator(const std::vector<size_t> &next, size_t id)
+		    : Next_(&next), Id_(id) {
+		}
+
+	private:
+		const std::vector<size_t> *Next_ = nullptr;
+		size_t Id_ = NONE;
+	};
+
+	// appends a new property as the weakest stay, reusing the id of a
+	// removed one if there is any
+	size_t Add() {
+		size_t id = Next_.size();
+		if (!Free_.empty()) {
+			id = Free_.back();
+			Free_.pop_back();
+			Next_[id] = NONE;
+			Prev_[id] = Tail_;
+		} else {
+			Next_.push_back(NONE);
+			Prev_.push_back(Tail_);
+		}
+		Attached_.resize(Next_.size(), 0);
+		Attached_[id] = 1;
+		++Count_;
+		if (Tail_ != NONE) {
+			Next_[Tail_] = id;
+		} else {
+			Head_ = id;
+		}
+		Tail_ = id;
+		return id;
+	}
+
+	void Remove(size_t id) {
+		Unlink(id);
+		Attached_[id] = 0;
+		Free_.push_back(id);
+		--Count_;
+	}
+
+	// returns false if the property already was the strongest stay
+	bool MoveToFront(size_t id) {
+		if (Head_ == id) {
+			return false;
+		}
+
+		Unlink(id);
+		Prev_[id] = NONE;
+		Next_[id] = Head_;
+		if (Head_ != NONE) {
+			Prev_[Head_] = id;
+		} else {
+			Tail_ = id;
+		}
+		Head_ = id;
+		return true;
+	}
+
+	// moves the property right behind previous, to the front for NONE;
+	// undoes a MoveToFront given the previous neighbour it had
+	void MoveAfter(size_t id, size_t previous) {
+		if (previous == NONE) {
+			MoveToFront(id);
+			return;
+		}
+
+		Unlink(id);
+		Prev_[id] = previous;
+		Next_[id] = Next_[previous];
+		if (Next_[previous] != NONE) {
+			Prev_[Next_[previous]] = id;
+		} else {
+			Tail_ = id;
+		}
+		Next_[previous] = id;
+	}
+
+	[[nodiscard]] size_t Front() const {
+		return Head_;
+	}
+
+	// upper bound of ids, removed ones included
+	[[nodiscard]] size_t Size() const {
+		return Next_.size();
+	}
+
+	[[nodiscard]] size_t Count() const {
+		return Count_;
+	}
+
+	[[nodiscard]] size_t Previous(size_t id) const {
+		return Prev_[id];
+	}
+
+	[[nodiscard]] bool Contains(size_t id) const {
+		return id < Attached_.size() && Attached_[id];
+	}
+
+	[[nodiscard]] TIterator begin() const {
+		return {Next_, Head_};
+	}
+
+	[[nodiscard]] TIterator end() const {
+		return {Next_, NONE};
+	}
+
+private:
+	void Unlink(size_t id) {
+		if (Prev_[id] != NONE) {
+			Next_[Prev_[id]] = Next_[id];
+		} else {
+			Head_ = Next_[id];
+		}
+		if (Next_[id] != NONE) {
+			Prev_[Next_[id]] = Prev_[id];
+		} else {
+			Tail_ = Prev_[id];
+		}
+	}
+
+private:
+	size_t Head_ = NONE;
+	size_t Tail_ = NONE;
+	size_t Count_ = 0;
+	std::vector<size_t> Prev_;
+	std::vector<size_t> Next_;
+	std::vector<uint8_t> Attached_;
+	std::vector<size_t> Free_;
+};
+
+}  // namespace NPropertyModels
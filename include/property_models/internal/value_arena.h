@@ -0,0 +1,134 @@
+#pragma once
+
+#ifndef NPROPERTY_MODELS_IMPL_ALLOWED
+#error "This header may not be included directly. Please include \"property_models/model.h\" instead"
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace NPropertyModels {
+
+// Values of any type stored one after another in blocks. Blocks are kept
+// when values are released, so once the arena has grown to what a log of
+// edits needs, saving values does not allocate, apart from what copying a
+// value allocates itself. Values are released in reverse order, either all
+// at once or back to a mark.
+class TValueArena {
+public:
+	struct TMark {
+		size_t Block = 0;
+		size_t Used = 0;
+		size_t Destructors = 0;
+	};
+
+	TValueArena() = default;
+	TValueArena(const TValueArena &) = delete;
+	TValueArena(TValueArena &&other) noexcept {
+		Swap(other);
+	}
+	TValueArena &operator=(const TValueArena &) = delete;
+	TValueArena &operator=(TValueArena &&) = delete;
+
+	~TValueArena() {
+		Clear();
+	}
+
+	// Constructs a copy of value in the arena. A value that can not be copied
+	// is moved instead, the caller overwrites it anyway.
+	template <typename TValue>
+	TValue *Save(TValue &value) {
+		// blocks are allocated with the default alignment of new
+		static_assert(alignof(TValue) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Over-aligned values can not be saved.");
+		void *storage = Allocate(sizeof(TValue), alignof(TValue));
+		TValue *saved = nullptr;
+		if constexpr (std::is_copy_constructible_v<TValue>) {
+			saved = ::new (storage) TValue(value);
+		} else {
+			saved = ::new (storage) TValue(std::move(value));
+		}
+		if constexpr (!std::is_trivially_destructible_v<TValue>) {
+			Destructors_.emplace_back(saved, [](void *pointer) { static_cast<TValue *>(pointer)->~TValue(); });
+		}
+		return saved;
+	}
+
+	[[nodiscard]] TMark GetMark() const {
+		return {Block_, Used_, Destructors_.size()};
+	}
+
+	// destroys the values saved after the mark
+	void Rollback(const TMark &mark) {
+		while (Destructors_.size() > mark.Destructors) {
+			auto [pointer, destroy] = Destructors_.back();
+			Destructors_.pop_back();
+			destroy(pointer);
+		}
+		Block_ = mark.Block;
+		Used_ = mark.Used;
+	}
+
+	void Clear() {
+		Rollback({});
+	}
+
+	void Swap(TValueArena &other) noexcept {
+		// blocks do not move, saved values stay where they are
+		Blocks_.swap(other.Blocks_);
+		Destructors_.swap(other.Destructors_);
+		std::swap(Block_, other.Block_);
+		std::swap(Used_, other.Used_);
+	}
+
+private:
+	static constexpr size_t MIN_BLOCK_SIZE = 256;
+
+	struct TBlock {
+		std::unique_ptr<std::byte[]> Data;
+		size_t Size = 0;
+	};
+
+	void *Allocate(size_t size, size_t alignment) {
+		while (Block_ < Blocks_.size()) {
+			TBlock &block = Blocks_[Block_];
+			size_t offset = (Used_ + alignment - 1) / alignment * alignment;
+			if (offset + size <= block.Size) {
+				Used_ = offset + size;
+				return block.Data.get() + offset;
+			}
+			if (Used_ == 0) {
+				// too small for the value, replaced below
+				break;
+			}
+			++Block_;
+			Used_ = 0;
+		}
+
+		size_t blockSize = std::max(size, MIN_BLOCK_SIZE);
+		if (Block_ > 0) {
+			blockSize = std::max(blockSize, 2 * Blocks_[Block_ - 1].Size);
+		}
+		TBlock block{std::make_unique_for_overwrite<std::byte[]>(blockSize), blockSize};
+		if (Block_ < Blocks_.size()) {
+			Blocks_[Block_] = std::move(block);
+		} else {
+			Blocks_.push_back(std::move(block));
+		}
+		Used_ = size;
+		return Blocks_[Block_].Data.get();
+	}
+
+private:
+	std::vector<TBlock> Blocks_;
+	// the block values are saved to and how much of it is used
+	size_t Block_ = 0;
+	size_t Used_ = 0;
+	std::vector<std::pair<void *, void (*)(void *)>> Destructors_;
+};
+
+}  // namespace NPropertyModels
@@ -1,12 +1,29 @@
 #pragma once
 
 #define NPROPERTY_MODELS_IMPL_ALLOWED
+#include "internal/executor/thread_pool.h"
 #include "internal/fwd.h"
+#include "internal/schema.h"
+#include "internal/solver/async_solver.h"
+#include "internal/solver/components.h"
+#include "internal/solver/plan_cache.h"
+#include "internal/solver/solver.h"
+#include "internal/stay_order.h"
+#include "internal/value_arena.h"
 #undef NPROPERTY_MODELS_IMPL_ALLOWED
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
 #include <type_traits>
+#include <utility>
+#include <variant>
 #include <vector>
 
 namespace NPropertyModels {
@@ -22,6 +39,23 @@ namespace NPropertyModels {
 #define PM_OUT NPROPERTY_MODELS_OUT_IMPL
 #define PM_CSM NPROPERTY_MODELS_CSM_IMPL
 
+// Properties whose values changed and constraints whose fulfillment
+// changed during one update, by id.
+struct TChangeSet {
+	std::vector<size_t> PropertyIds;
+	std::vector<size_t> ConstraintIds;
+};
+
+// Counters of executed CSMs, grouped by dependency level of the plan. The
+// achieved parallelism is ExecutedCSMs / Levels.
+struct TExecutionStats {
+	size_t ExecutedCSMs = 0;
+	// levels with at least one executed CSM
+	size_t Levels = 0;
+	size_t ParallelCSMs = 0;
+	size_t ParallelLevels = 0;
+};
+
 template <typename TModel>
 class TPropertyModel {
 public:
@@ -30,6 +64,13 @@ public:
 
 	void UnregisterCallback();
 
+	// Called once per update with the properties and constraints that
+	// changed, before the per-property and per-constraint callbacks.
+	template <typename... TArgs>
+	void RegisterChangesCallback(TArgs &&...args);
+
+	void UnregisterChangesCallback();
+
 	class TFreezeGuard {
 	public:
 		explicit TFreezeGuard(TPropertyModel &base);
@@ -45,6 +86,104 @@ public:
 	};
 	TFreezeGuard Freeze();
 
+	// What-if evaluation: edits made while the guard is alive, and all values
+	// derived from them, are rolled back by its destructor. Only the old
+	// values of properties that changed are kept, so a speculation costs as
+	// much as the edits themselves. Guards nest. Callbacks are not called
+	// for speculative updates and the structure of the model must not change
+	// meanwhile.
+	class TSpeculationGuard {
+	public:
+		explicit TSpeculationGuard(TPropertyModel &base);
+		TSpeculationGuard() = delete;
+		TSpeculationGuard(const TSpeculationGuard &) = delete;
+		TSpeculationGuard(TSpeculationGuard &&) = delete;
+		TSpeculationGuard &operator=(const TSpeculationGuard &) = delete;
+		TSpeculationGuard &operator=(TSpeculationGuard &&) = delete;
+		~TSpeculationGuard();
+
+	private:
+		TPropertyModel &Base_;
+	};
+	// may not be called while the model is frozen
+	TSpeculationGuard Speculate();
+	[[nodiscard]] bool IsSpeculating() const;
+
+	// Keeps the last capacity updates, each as the old values of the
+	// properties it changed plus its stay order moves and constraint edits.
+	// The values are copied into blocks that are reused once the oldest
+	// update is dropped. Undo and redo swap them back in without running any
+	// CSM, the solver only runs if the stay order or constraints differ.
+	// Zero disables the history, changing the capacity or the structure of
+	// the model clears it. Edits are not recorded in lazy mode.
+	void SetHistoryCapacity(size_t capacity);
+	[[nodiscard]] size_t GetUndoCount() const;
+	[[nodiscard]] size_t GetRedoCount() const;
+	// return false if there is nothing to undo or redo
+	bool Undo();
+	bool Redo();
+
+	void SetPlanCacheCapacity(size_t capacity);
+	[[nodiscard]] NSolver::TPlanCacheStats GetPlanCacheStats() const;
+
+	// In lazy mode updates only mark derived properties stale, they are
+	// recomputed on first read.
+	void SetLazyEvaluation(bool lazy);
+	[[nodiscard]] bool IsLazyEvaluation() const;
+
+	// Plans are computed once per model type and stay order and shared by
+	// all instances. When the first instance needs them, one plan is built
+	// for every most recently edited property with the remaining stays in
+	// declaration order. Other stay orders are solved when an instance first
+	// reaches them, up to a fixed number of orders. Plans are only used while
+	// constraints keep the importances and enabled flags they had when the
+	// first plans were built, otherwise the solver plans as usual.
+	void SetPrecomputedPlans(bool precomputed);
+	[[nodiscard]] bool IsPrecomputedPlans() const;
+
+	// In async mode a replan that the solver cache cannot answer is solved on
+	// a background thread while updates keep executing the previous plan.
+	// An update waits for the new plan only if the previous one would
+	// overwrite an edited property or constraints were enabled or disabled.
+	// Any later update installs the new plan once it is ready.
+	void SetAsyncPlanning(bool async);
+	[[nodiscard]] bool IsAsyncPlanning() const;
+	[[nodiscard]] bool IsPlanPending() const;
+	// waits for the pending plan and executes it
+	void AwaitPlan();
+
+	// CSMs of the same dependency level are independent of each other. With
+	// more than one thread, levels with at least threshold CSMs to execute
+	// run on a thread pool, smaller ones inline. CSMs must then be safe to
+	// run concurrently with each other. While speculating or recording
+	// history all levels run inline.
+	void SetParallelExecution(size_t threadsCount, size_t threshold = DEFAULT_PARALLEL_THRESHOLD);
+	[[nodiscard]] TExecutionStats GetExecutionStats() const;
+
+	static constexpr size_t DEFAULT_PARALLEL_THRESHOLD = 4;
+
+	// Calls function(reader) from any thread and returns its result once it
+	// has observed values of a single finished update, retrying if the
+	// writer got in between. The function reads properties and constraints
+	// of the model through the reader, which loads them atomically, so only
+	// values that are trivially copyable lock-free atomics can be read. It
+	// may see intermediate values of an update that is discarded, so it must
+	// not act on them. The writer never waits for readers, a frozen batch
+	// counts as one write. Returns nullopt after maxAttempts tries that found
+	// the writer busy. Not available in lazy mode, where reads recompute
+	// values. Called by the writer while the model is frozen, it always
+	// gives up.
+	template <typename TFunction>
+	std::optional<std::invoke_result_t<TFunction, const TSnapshotReader<TModel> &>> ReadSnapshot(
+	    TFunction &&function,
+	    size_t maxAttempts = DEFAULT_SNAPSHOT_ATTEMPTS
+	) const;
+
+	static constexpr size_t DEFAULT_SNAPSHOT_ATTEMPTS = 10'000;
+
+	// Even between updates, bumped by every update and every batch of edits.
+	[[nodiscard]] uint64_t GetVersion() const;
+
 protected:
 	using TThis = TModel;
 
@@ -54,33 +193,351 @@ private:
 	friend class TProperty;
 	template <typename>
 	friend class TConstraint;
+	friend class TModelTable<TModel>;
 	friend class TFreezeGuard;
+	friend class TSpeculationGuard;
 	TPropertyModel() = default;
 
+	// marks the model as updating and its values as being written
+	class TWriteGuard {
+	public:
+		explicit TWriteGuard(TPropertyModel &base);
+		TWriteGuard() = delete;
+		TWriteGuard(const TWriteGuard &) = delete;
+		TWriteGuard(TWriteGuard &&) = delete;
+		TWriteGuard &operator=(const TWriteGuard &) = delete;
+		TWriteGuard &operator=(TWriteGuard &&) = delete;
+		~TWriteGuard();
+
+	private:
+		TPropertyModel &Base_;
+	};
+
 private:
 	size_t RegisterProperty();
 	size_t RegisterConstraint(TConstraint<TThis> &constraint);
+	template <typename TValue>
+	size_t DeclareProperty(TProperty<TValue, TThis> &property);
+	size_t DeclareConstraint(TConstraint<TThis> &constraint);
+	size_t AttachProperty();
+	// declared members get the first ids and are only destroyed together
+	// with the whole model
+	[[nodiscard]] bool IsDeclaredProperty(size_t id) const;
+	[[nodiscard]] bool IsDeclaredConstraint(size_t id) const;
+	void DetachProperty(size_t id);
+	void DetachConstraint(size_t id);
+	void OnStructureChanged();
+	void OnConstraintAttached(size_t id);
+	[[nodiscard]] bool IsConstraintEnabled(size_t id) const;
+	void OnPropertyGet(size_t id);
+	void OnPropertyBeforeSet(size_t id);
 	void OnPropertySet(size_t id);
+	void OnConstraintBeforeSet(size_t id);
 	void OnConstraintSet(size_t id);
+	void OnConstraintImportanceSet(size_t id);
+	[[nodiscard]] bool ConstraintLess(size_t a, size_t b) const;
+	void SortConstraints();
+	bool RepositionConstraint(size_t id);
 	void Update();
+	void Plan();
+	void PlanWithSolver();
+	bool PlanInBackground();
+	void BuildPlanSignature();
+	void BuildTask(bool withTask);
+	bool PlanPrecomputed();
+	void Execute();
+	void ExecuteLevel(size_t begin, size_t end);
+	bool CollectRowCSMs(std::vector<const TCSM<TThis> *> &csms);
+	void MakeTableRow();
+	void MarkDirty(size_t id);
+	void ListDirty(size_t id);
+	[[nodiscard]] bool IsAffected(const TCSM<TThis> &csm) const;
+	void Evaluate(size_t id);
+	void FlushStale();
+	void BeginWrite();
+	void EndWrite();
 	void DoFreeze();
 	void DoUnfreeze();
+	void DoSpeculate();
+	void DoRollback();
+	template <typename TValue>
+	void SaveProperty(size_t id, TValue &value);
+	void SaveConstraint(size_t id);
+	void SaveStayMove(size_t id, size_t previous);
+	[[nodiscard]] bool IsRecordingHistory() const;
+	void OpenHistoryStep();
+	void CommitHistoryStep();
+	void ClearHistory();
+	void ApplyHistoryStep(size_t slot, bool undo);
+	void CollectChanges();
 	void DoCallback();
 
 private:
-	bool Freezed_ = false;
+	static constexpr size_t COMPONENT_CACHE_CAPACITY = 256;
+
+	struct TPrecomputedPlan {
+		// (constraint id, CSM index) in execution order
+		std::vector<std::pair<size_t, size_t>> CSMs;
+		std::vector<size_t> FulfilledConstraintIds;
+	};
+
+	// looks up a stay order without copying it into a key
+	struct TStayOrderLess {
+		using is_transparent = void;
+
+		template <typename TLeft, typename TRight>
+		bool operator()(const TLeft &left, const TRight &right) const {
+			return std::lexicographical_compare(left.begin(), left.end(), right.begin(), right.end());
+		}
+	};
+
+	struct TPrecomputedPlans {
+		std::vector<bool> Enabled;
+		std::vector<size_t> Importances;
+		// the task of the declared constraints, its stays are filled in for
+		// every stay order that is solved
+		NSolver::TTask Task;
+		// (constraint id, CSM index) of the CSMs of the task before the stays
+		std::vector<std::pair<size_t, size_t>> BackReferences;
+		std::shared_mutex Mutex;
+		// entries are never removed
+		std::map<std::vector<size_t>, TPrecomputedPlan, TStayOrderLess> ByStayOrder;
+	};
+
+	static constexpr size_t PRECOMPUTED_PLANS_CAPACITY = 4096;
+
+	TPrecomputedPlans &GetPrecomputedPlans();
+	void BuildPrecomputedPlans(TPrecomputedPlans &plans) const;
+	// called with the mutex of the plans held exclusively
+	static const TPrecomputedPlan &SolvePrecomputedPlan(TPrecomputedPlans &plans, const std::vector<size_t> &stayOrder);
+
+	struct TSavedValue {
+		size_t PropertyId;
+		// speculation depth the property was saved at before this entry
+		size_t PreviousDepth;
+		// the value of the property and its old value in the arena of the log
+		void *Value;
+		void *Saved;
+		void (*Swap)(void *, void *);
+	};
+
+	struct TSavedConstraint {
+		size_t ConstraintId;
+		bool Enabled;
+		size_t Importance;
+	};
+
+	struct TSavedStayMove {
+		size_t PropertyId;
+		// the stay in front of it before it was moved to the front
+		size_t Previous;
+		bool Undone;
+	};
+
+	struct TSavedLastSet {
+		std::optional<size_t> PropertyId;
+	};
+
+	// applying an entry exchanges the saved state with the current one, so
+	// that applying it again redoes it
+	using TUndoEntry = std::variant<TSavedValue, TSavedConstraint, TSavedStayMove, TSavedLastSet>;
+
+	struct TUndoLog {
+		std::vector<TUndoEntry> Entries;
+		TValueArena Values;
+
+		void Clear() {
+			Entries.clear();
+			Values.Clear();
+		}
+
+		void Swap(TUndoLog &other) {
+			Entries.swap(other.Entries);
+			Values.Swap(other.Values);
+		}
+	};
+
+	struct TSpeculationBegin {
+		size_t Entry;
+		TValueArena::TMark Values;
+	};
+
+	// State that only some models need is allocated on first use, so that
+	// an instance that never uses it only pays for a pointer.
+
+	struct TSpeculation {
+		// undo log of the open speculations, each starts at its begin
+		TUndoLog UndoLog;
+		std::vector<TSpeculationBegin> Begins;
+		// deepest speculation that saved the property, a property is saved
+		// once per speculation
+		std::vector<size_t> UndoDepths;
+	};
+
+	struct THistory {
+		// ring of recorded updates: the oldest is at First, the first
+		// Position of Count can be undone, the rest redone; slots keep their
+		// storage when they are reused
+		std::vector<TUndoLog> Slots;
+		size_t First = 0;
+		size_t Count = 0;
+		size_t Position = 0;
+		// entries of the update in progress, a property is saved once per
+		// step
+		TUndoLog Step;
+		size_t Serial = 1;
+		std::vector<size_t> Serials;
+	};
+
+	struct TCallbacks {
+		std::function<void()> Model;
+		std::function<void(const TChangeSet &)> Changes;
+		std::vector<std::function<void()>> Properties;
+		std::vector<std::function<void()>> Constraints;
+		// filled after each execution and delivered to the callbacks
+		TChangeSet ChangeSet;
+		std::vector<uint8_t> WasFulfilled;
+	};
+
+	// allocated once the solver or its plan cache is first needed
+	struct TSolverState {
+		NSolver::TSolver Solver = NSolver::GetSolver();
+		NSolver::TTask Task{};
+		std::vector<const TCSM<TThis> *> BackPointers;
+		std::vector<size_t> BackConstraintIds;
+		std::vector<size_t> ComponentKeys;
+		NSolver::TSolution Solution;
+		NSolver::TPlanSignature PlanSignature;
+		NSolver::TPlanCache PlanCache;
+		// solutions of independent parts of the task, survives structural
+		// changes that only touch other parts
+		NSolver::TPlanCache ComponentCache{COMPONENT_CACHE_CAPACITY};
+	};
+
+	// the task with PendingSignature is being solved
+	struct TAsyncPlanning {
+		NSolver::TAsyncSolver Solver;
+		NSolver::TPlanSignature PendingSignature;
+		NSolver::TSolutionFuture PendingSolution;
+		// empty until the first plan made with async planning on
+		std::vector<uint8_t> PlannedEnabled;
+	};
+
+	struct TParallelExecution {
+		TParallelExecution(size_t threadsCount, size_t threshold)
+		    : ThreadPool(threadsCount), Threshold(threshold) {
+		}
+
+		NExecutor::TThreadPool ThreadPool;
+		size_t Threshold;
+	};
+
+	TCallbacks &GetCallbacks();
+	TSolverState &GetSolverState();
+
+	// the log edits are saved to, nullptr when they are not saved
+	TUndoLog *GetUndoLog();
+	void ApplyUndoEntry(TUndoEntry &entry);
+
+private:
+	size_t FreezeDepth_ = 0;
 	bool Updating_ = false;
-	std::function<void()> Callback_;
-	size_t Time_ = 0;
-	std::vector<size_t> PropertySetTime_;
-	std::vector<std::reference_wrapper<TConstraint<TThis>>> Constraints_;
+	// a row of a model table: edits and constraint flags are tracked and
+	// planned by the table, the row itself never plans or executes
+	bool TableRow_ = false;
+	std::unique_ptr<TSpeculation> Speculation_;
+	std::unique_ptr<THistory> History_;
+	// seqlock for ReadSnapshot, odd while values are being written
+	std::atomic<uint64_t> Version_ = 0;
+	// changes are only collected once a callback is registered
+	std::unique_ptr<TCallbacks> Callbacks_;
+	TStayOrder StayOrder_;
+	// detached constraints leave a nullptr until their id is reused
+	std::vector<TConstraint<TThis> *> Constraints_;
+	std::vector<size_t> FreeConstraintIds_;
+	// unique for every attached constraint, ids are reused
+	std::vector<size_t> ConstraintSerials_;
+	size_t NextConstraintSerial_ = 0;
+	size_t DeclaredPropertiesCount_ = 0;
+	size_t DeclaredConstraintsCount_ = 0;
+	// precomputed plans only describe the declared structure
+	bool Restructured_ = false;
+	bool StructureChanged_ = false;
+
+	// last plan, reused until enabled set, importances or stay order change
+	bool PlanValid_ = false;
+	std::optional<size_t> LastSetPropertyId_;
+	// constraints by importance, ties broken by id
+	bool ConstraintOrderValid_ = false;
+	std::vector<size_t> ConstraintOrder_;
+	std::vector<size_t> ConstraintPositions_;
+	std::unique_ptr<TSolverState> SolverState_;
+	std::vector<const TCSM<TThis> *> PlannedCSMs_;
+	std::vector<size_t> PlannedConstraintIds_;
+	// index of the CSM of every constraint in the plan that was executed
+	std::vector<size_t> SelectedCSMs_;
+	bool PlanChanged_ = false;
+	bool PrecomputedPlans_ = false;
+	std::unique_ptr<TAsyncPlanning> AsyncPlanning_;
+
+	// properties set since the last execution, listed in DirtyIds_ unless
+	// marked by a CSM running on the thread pool
+	bool FullExecution_ = true;
+	std::vector<uint8_t> Dirty_;
+	std::vector<size_t> DirtyIds_;
+	bool ExecutingParallel_ = false;
+
+	// planned CSMs ordered by dependency level, level i is
+	// [LevelBegins_[i], LevelBegins_[i + 1])
+	std::vector<const TCSM<TThis> *> LeveledCSMs_;
+	std::vector<size_t> LevelBegins_;
+	// where the next CSM of each level goes while leveling
+	std::vector<size_t> LevelEnds_;
+	std::vector<size_t> PropertyLevels_;
+	std::vector<const TCSM<TThis> *> Batch_;
+	std::unique_ptr<TParallelExecution> ParallelExecution_;
+	TExecutionStats ExecutionStats_;
+
+	// lazy evaluation: stale properties are recomputed by their producer
+	bool Lazy_ = false;
+	bool Evaluating_ = false;
+	std::vector<const TCSM<TThis> *> Producers_;
+	std::vector<uint8_t> Stale_;
+	std::vector<size_t> StaleIds_;
 };
 
+// Whether snapshot readers can load values of the type while the writer
+// stores them.
+template <typename TValue>
+consteval bool IsSnapshotValue() {
+	if constexpr (std::is_trivially_copyable_v<TValue>) {
+		return std::atomic_ref<TValue>::is_always_lock_free;
+	} else {
+		return false;
+	}
+}
+
+template <typename TValue>
+consteval size_t GetValueAlignment() {
+	if constexpr (IsSnapshotValue<TValue>()) {
+		return std::atomic_ref<TValue>::required_alignment;
+	} else {
+		return alignof(TValue);
+	}
+}
+
+// passed by PM_PROPERTY, declared properties are made together with the
+// model
+struct TDeclared {};
+
 template <typename TValue, typename TModel>
 class TProperty {
 public:
+	// Attaches a property to a live model.
 	template <typename... TArgs>
 	explicit(false) TProperty(TModel &model, TArgs &&...args);
+	template <typename... TArgs>
+	TProperty(TDeclared, TModel &model, TArgs &&...args);
 	TProperty(const TProperty &other) = delete;
 	TProperty(TProperty &&other) = delete;
 
@@ -97,13 +554,35 @@ public:
 	const TValue &Set(const TValue &value);
 	const TValue &Set(TValue &&value);
 
+	[[nodiscard]] size_t GetId() const;
+
+	// Called after every update that changed the value.
+	template <typename... TArgs>
+	void RegisterCallback(TArgs &&...args);
+
+	void UnregisterCallback();
+
+	// Properties may be created and destroyed while the model is alive, the
+	// destructor detaches the property. Constraints using it have to be
+	// destroyed first.
+	~TProperty();
+
 private:
 	friend TModel;
 	friend TPropertyModel<TModel>;
-	~TProperty();
+	friend TSnapshotReader<TModel>;
+	friend TTypedColumn<TValue, TModel>;
 
 private:
+	template <typename TOther>
+	[[nodiscard]] bool Equals(const TOther &other) const;
+
+	// snapshot readers may load the value while it is stored
+	template <typename TOther>
+	void Store(TOther &&other);
+
 	void OnGet() const;
+	void OnBeforeSet();
 	void OnSet();
 
 	template <EAccess ACCESS_, typename TModel_, typename... TValues_>
@@ -116,7 +595,7 @@ private:
 private:
 	TModel &Model_;
 	const size_t Id_;
-	TValue Value_;
+	alignas(GetValueAlignment<TValue>()) TValue Value_;
 };
 
 template <typename TModel>
@@ -131,23 +610,48 @@ public:
 	// NOLINTNEXTLINE
 	[[nodiscard]] explicit(false) operator bool() const;
 
+	[[nodiscard]] size_t GetId() const;
+
+	// Called after every update that changed IsFulfilled().
+	template <typename... TArgs>
+	void RegisterCallback(TArgs &&...args);
+
+	void UnregisterCallback();
+
+	// Attaches a constraint to a live model, its CSMs are made with
+	// TCSM::Make. The model is updated right away, or when it is unfrozen.
+	// A detached constraint only takes effect with the next update, as a
+	// destructor can not report a throwing CSM. Only the independent parts
+	// of the model that structural changes touch are solved again.
+	TConstraint(TModel &model, size_t importance, std::vector<TCSM<TModel>> csms);
+	TConstraint(const TConstraint &) = delete;
+	TConstraint(TConstraint &&) = delete;
+	TConstraint &operator=(const TConstraint &) = delete;
+	TConstraint &operator=(TConstraint &&) = delete;
+	// detaches the constraint
+	~TConstraint();
+
 private:
 	friend TModel;
 	friend TPropertyModel<TModel>;
+	friend TSnapshotReader<TModel>;
 
+	// declared constraints get functions making their CSMs, which are only
+	// called for the first instance of the model type
 	template <typename... T>
-	    requires((std::same_as<std::remove_cvref_t<T>, TCSM<TModel>> && ...))
-	explicit TConstraint(TModel &model, size_t importance, T &&...csms);
+	    requires((std::is_invocable_r_v<TCSM<TModel>, T> && ...))
+	explicit TConstraint(TModel &model, size_t importance, T &&...makeCSMs);
 
 	template <typename... T>
-	    requires((std::same_as<std::remove_cvref_t<T>, TCSM<TModel>> && ...))
-	explicit TConstraint(TModel &model, T &&...csms);
-
-	~TConstraint();
+	    requires((std::is_invocable_r_v<TCSM<TModel>, T> && ...))
+	explicit TConstraint(TModel &model, T &&...makeCSMs);
 
 private:
-	[[nodiscard]] std::vector<std::reference_wrapper<TCSM<TModel>>> GetCSMs();
+	[[nodiscard]] const std::vector<TCSM<TModel>> &GetCSMs() const;
 	void OnSet();
+	// snapshot readers may load the flags while they are stored
+	void SetEnabled(bool enabled);
+	void SetFulfilled(bool fulfilled);
 
 private:
 	TModel &Model_;
@@ -157,7 +661,24 @@ private:
 	bool Enabled_ = true;
 	bool Fulfilled_ = true;
 
-	std::vector<TCSM<TModel>> CSMs_;
+	// in the schema of the model type, or owned for constraints attached at
+	// runtime
+	const std::vector<TCSM<TModel>> *CSMs_ = nullptr;
+	std::unique_ptr<const std::vector<TCSM<TModel>>> OwnCSMs_;
+};
+
+// Loads values of a model that another thread may be updating, given to the
+// function of TPropertyModel::ReadSnapshot.
+template <typename TModel>
+class TSnapshotReader {
+public:
+	template <typename TValue>
+	[[nodiscard]] TValue Get(const TProperty<TValue, TModel> &property) const;
+	[[nodiscard]] bool IsFulfilled(const TConstraint<TModel> &constraint) const;
+
+private:
+	friend TPropertyModel<TModel>;
+	TSnapshotReader() = default;
 };
 
 }  // namespace NPropertyModels
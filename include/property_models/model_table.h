@@ -0,0 +1,129 @@
+#pragma once
+
+#include "model.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace NPropertyModels {
+
+// N instances of the same model type, stored as one column of values per
+// property. Rows that were edited in the same order share a stay order and
+// therefore a plan: they form a group with a single planner, so planning is
+// paid once per edit pattern instead of once per row. Constraint flags are
+// the same for all rows.
+//
+// CSM bodies are written against the properties of a model, so a row is
+// executed by copying the values it needs into a cursor model, running the
+// CSMs on it and copying their outputs back. Vectorizing CSMs over whole
+// columns would need CSM bodies compiled against columns instead.
+//
+// Only declared properties can be stored, properties attached at runtime
+// are not part of the model type.
+template <typename TModel>
+class TModelTable {
+public:
+	explicit TModelTable(size_t size);
+	TModelTable(const TModelTable &) = delete;
+	TModelTable(TModelTable &&) = delete;
+	TModelTable &operator=(const TModelTable &) = delete;
+	TModelTable &operator=(TModelTable &&) = delete;
+	~TModelTable() = default;
+
+public:
+	[[nodiscard]] size_t Size() const;
+
+	template <typename TValue>
+	[[nodiscard]] typename std::vector<TValue>::const_reference Get(size_t row, TProperty<TValue, TModel> TModel::*property) const;
+	template <typename TValue>
+	[[nodiscard]] const std::vector<TValue> &GetColumn(TProperty<TValue, TModel> TModel::*property) const;
+
+	// writing an equal value is not an edit, as for a single model
+	template <typename TValue, typename TOther>
+	void Set(size_t row, TProperty<TValue, TModel> TModel::*property, TOther &&value);
+
+	// assigns values[row] to every row
+	template <typename TValue, typename TValues>
+	void SetColumn(TProperty<TValue, TModel> TModel::*property, const TValues &values);
+
+	// the constraint as planned for the row
+	[[nodiscard]] const TConstraint<TModel> &GetConstraint(size_t row, TConstraint<TModel> TModel::*constraint) const;
+	void SetImportance(TConstraint<TModel> TModel::*constraint, size_t importance);
+	void Enable(TConstraint<TModel> TModel::*constraint);
+	void Disable(TConstraint<TModel> TModel::*constraint);
+
+	// number of distinct edit patterns among the rows
+	[[nodiscard]] size_t GetGroupsCount() const;
+
+private:
+	static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+	enum class ERowState : uint8_t {
+		CLEAN,
+		// edited within its group, runs the affected CSMs
+		EDITED,
+		// moved to another group, runs its whole plan
+		MOVED,
+	};
+
+	struct TGroup {
+		// plans for the rows of the group, its own values are never used
+		std::unique_ptr<TModel> Planner;
+		// the stay order of the planner, most recently edited property first
+		std::vector<size_t> Key;
+		std::vector<size_t> Rows;
+		// rows that are not clean
+		std::vector<size_t> PendingRows;
+	};
+
+	// the CSMs a row runs and the properties they access
+	struct TBatch {
+		std::vector<const TCSM<TModel> *> CSMs;
+		std::vector<size_t> LoadIds;
+		std::vector<size_t> StoreIds;
+	};
+
+private:
+	template <typename TValue>
+	[[nodiscard]] TTypedColumn<TValue, TModel> &GetTypedColumn(TProperty<TValue, TModel> TModel::*property) const;
+	[[nodiscard]] static TPropertyModel<TModel> &GetBase(TModel &model);
+	void EditRows(size_t propertyId);
+	size_t FindGroup(size_t sourceGroupId, size_t propertyId);
+	void MoveRow(size_t row, size_t groupId);
+	void MarkRow(TGroup &group, size_t row, ERowState state);
+	void RemoveEmptyGroups();
+	void PrepareBatch(TBatch &batch);
+	void ExecuteRow(size_t row, const TBatch &batch);
+	void Update();
+
+private:
+	// runs the CSMs of every row, its values are those of the last row run
+	TModel Cursor_;
+	// by property id
+	std::vector<std::unique_ptr<TColumn<TModel>>> Columns_;
+
+	std::vector<std::unique_ptr<TGroup>> Groups_;
+	std::map<std::vector<size_t>, size_t> GroupIds_;
+	std::vector<size_t> RowGroups_;
+	// of each row in the rows of its group
+	std::vector<size_t> RowPositions_;
+	std::vector<ERowState> RowStates_;
+
+	// reused between edits
+	std::vector<size_t> EditedRows_;
+	std::vector<size_t> TargetGroups_;
+	std::vector<size_t> Key_;
+	std::vector<uint8_t> Accessed_;
+	TBatch Affected_;
+	TBatch Planned_;
+};
+
+}  // namespace NPropertyModels
+
+#define NPROPERTY_MODELS_IMPL_ALLOWED
+#include "internal/model_table.impl.h"
+#undef NPROPERTY_MODELS_IMPL_ALLOWED
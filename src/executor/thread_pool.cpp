@@ -0,0 +1,127 @@
+#define NPROPERTY_MODELS_IMPL_ALLOWED
+#include "internal/executor/thread_pool.h"
+#undef NPROPERTY_MODELS_IMPL_ALLOWED
+
+namespace NPropertyModels::NExecutor {
+
+TThreadPool::TThreadPool(size_t threadsCount) {
+	threadsCount = std::max<size_t>(threadsCount, 1);
+	for (size_t worker = 0; worker < threadsCount; ++worker) {
+		Queues_.push_back(std::make_unique<TQueue>());
+	}
+	// queue 0 belongs to the caller of Run
+	for (size_t worker = 1; worker < threadsCount; ++worker) {
+		Threads_.emplace_back([this, worker]() { Loop(worker); });
+	}
+}
+
+TThreadPool::~TThreadPool() {
+	{
+		std::lock_guard lock(Mutex_);
+		Stopping_ = true;
+	}
+	WakeUp_.notify_all();
+	for (auto &thread : Threads_) {
+		thread.join();
+	}
+}
+
+size_t TThreadPool::GetThreadsCount() const {
+	return Queues_.size();
+}
+
+void TThreadPool::Run(size_t count, const std::function<void(size_t)> &task) {
+	if (count == 0) {
+		return;
+	}
+
+	size_t generation = 0;
+	{
+		std::lock_guard lock(Mutex_);
+		generation = ++Generation_;
+		Remaining_.store(count);
+		for (size_t index = 0; index < count; ++index) {
+			TQueue &queue = *Queues_[index % Queues_.size()];
+			std::lock_guard queueLock(queue.Mutex);
+			queue.Items.emplace_back(generation, index);
+		}
+		Task_ = &task;
+	}
+	WakeUp_.notify_all();
+
+	Work(0, generation, task);
+
+	std::exception_ptr error;
+	{
+		std::unique_lock lock(Mutex_);
+		Done_.wait(lock, [this]() { return Remaining_.load() == 0; });
+		Task_ = nullptr;
+		error = std::exchange(Error_, nullptr);
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+bool TThreadPool::TryPop(size_t worker, size_t generation, size_t &index) {
+	{
+		TQueue &queue = *Queues_[worker];
+		std::lock_guard lock(queue.Mutex);
+		if (!queue.Items.empty() && queue.Items.back().first == generation) {
+			index = queue.Items.back().second;
+			queue.Items.pop_back();
+			return true;
+		}
+	}
+
+	for (size_t offset = 1; offset < Queues_.size(); ++offset) {
+		TQueue &victim = *Queues_[(worker + offset) % Queues_.size()];
+		std::lock_guard lock(victim.Mutex);
+		if (!victim.Items.empty() && victim.Items.front().first == generation) {
+			index = victim.Items.front().second;
+			victim.Items.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void TThreadPool::Work(size_t worker, size_t generation, const std::function<void(size_t)> &task) {
+	size_t index = 0;
+	while (TryPop(worker, generation, index)) {
+		try {
+			task(index);
+		} catch (...) {
+			std::lock_guard lock(Mutex_);
+			if (!Error_) {
+				Error_ = std::current_exception();
+			}
+		}
+
+		if (Remaining_.fetch_sub(1) == 1) {
+			std::lock_guard lock(Mutex_);
+			Done_.notify_all();
+		}
+	}
+}
+
+void TThreadPool::Loop(size_t worker) {
+	size_t seen = 0;
+	while (true) {
+		const std::function<void(size_t)> *task = nullptr;
+		{
+			std::unique_lock lock(Mutex_);
+			WakeUp_.wait(lock, [this, seen]() { return Stopping_ || Generation_ != seen; });
+			if (Stopping_) {
+				return;
+			}
+			seen = Generation_;
+			task = Task_;
+		}
+		if (task) {
+			Work(worker, seen, *task);
+		}
+	}
+}
+
+}  // namespace NPropertyModels::NExecutor
@@ -0,0 +1,50 @@
+#define NPROPERTY_MODELS_IMPL_ALLOWED
+#include "internal/solver/async_solver.h"
+#undef NPROPERTY_MODELS_IMPL_ALLOWED
+
+namespace NPropertyModels::NSolver {
+
+TAsyncSolver::TAsyncSolver(TSolver solver)
+    : Solver_(std::move(solver)), Thread_([this]() { Run(); }) {
+}
+
+TAsyncSolver::~TAsyncSolver() {
+	{
+		std::lock_guard lock(Mutex_);
+		Stopping_ = true;
+	}
+	Condition_.notify_one();
+	Thread_.join();
+}
+
+TSolutionFuture TAsyncSolver::Submit(TTask task) {
+	std::promise<std::optional<TSolution>> promise;
+	TSolutionFuture future = promise.get_future().share();
+	{
+		std::lock_guard lock(Mutex_);
+		Queued_.emplace(std::move(task), std::move(promise));
+	}
+	Condition_.notify_one();
+	return future;
+}
+
+void TAsyncSolver::Run() {
+	while (true) {
+		std::unique_lock lock(Mutex_);
+		Condition_.wait(lock, [this]() { return Stopping_ || Queued_.has_value(); });
+		if (Stopping_) {
+			return;
+		}
+		auto [task, promise] = std::move(*Queued_);
+		Queued_.reset();
+		lock.unlock();
+
+		try {
+			promise.set_value(Solver_.TrySolve(task));
+		} catch (...) {
+			promise.set_exception(std::current_exception());
+		}
+	}
+}
+
+}  // namespace NPropertyModels::NSolver
@@ -39,6 +39,7 @@ std::optional<TSolution> TCombinedSolver::TrySolve(const TTask &task) const {
 				if (maybeResult) {
 					return maybeResult;
 				}
+				[[fallthrough]];
 			}
 			case EApplicability::MAYBE_APPLICABLE: {
 				maybeApplicableSlaves.emplace_back(slave);
@@ -0,0 +1,164 @@
+#define NPROPERTY_MODELS_IMPL_ALLOWED
+#include "internal/solver/components.h"
+#undef NPROPERTY_MODELS_IMPL_ALLOWED
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace NPropertyModels::NSolver {
+
+namespace {
+
+constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+class TDisjointSets {
+public:
+	explicit TDisjointSets(size_t size)
+	    : Parents_(size) {
+		std::iota(Parents_.begin(), Parents_.end(), 0u);
+	}
+
+	size_t Find(size_t id) {
+		while (Parents_[id] != id) {
+			Parents_[id] = Parents_[Parents_[id]];
+			id = Parents_[id];
+		}
+		return id;
+	}
+
+	void Unite(size_t a, size_t b) {
+		a = Find(a);
+		b = Find(b);
+		if (a != b) {
+			Parents_[std::max(a, b)] = std::min(a, b);
+		}
+	}
+
+private:
+	std::vector<size_t> Parents_;
+};
+
+struct TComponent {
+	std::vector<size_t> CSMIds;
+	std::vector<size_t> ConstraintIds;
+};
+
+}  // namespace
+
+std::optional<TSolution> SolveByComponents(
+    const TSolver &solver,
+    const TTask &task,
+    const std::vector<size_t> &constraintKeys,
+    TPlanCache &cache,
+    size_t minCapacity
+) {
+	// properties are vertices, constraints without properties get their own
+	// vertex after them
+	TDisjointSets sets(task.PropertiesCount + task.ConstraintsCount);
+	std::vector<size_t> anchors(task.ConstraintsCount, NONE);
+	for (const auto &csm : task.CSMs) {
+		size_t &anchor = anchors[csm.ConstraintId];
+		for (const auto &ids : {std::cref(csm.InputPropertyIds), std::cref(csm.OutputPropertyIds)}) {
+			for (const auto &id : ids.get()) {
+				if (anchor == NONE) {
+					anchor = id;
+				}
+				sets.Unite(anchor, id);
+			}
+		}
+	}
+
+	std::vector<size_t> componentByRoot(task.PropertiesCount + task.ConstraintsCount, NONE);
+	std::vector<TComponent> components;
+	for (size_t csmId = 0; csmId < task.CSMs.size(); ++csmId) {
+		size_t constraintId = task.CSMs[csmId].ConstraintId;
+		size_t anchor = anchors[constraintId];
+		size_t root = anchor == NONE ? task.PropertiesCount + constraintId : sets.Find(anchor);
+		if (componentByRoot[root] == NONE) {
+			componentByRoot[root] = components.size();
+			components.emplace_back();
+		}
+		TComponent &component = components[componentByRoot[root]];
+		component.CSMIds.push_back(csmId);
+		component.ConstraintIds.push_back(constraintId);
+	}
+
+	// components may not fit otherwise, and would evict each other
+	const size_t capacity = std::max(minCapacity, 2 * components.size());
+	cache.SetCapacity(std::max(cache.GetStats().Capacity, capacity));
+
+	TSolution solution;
+	TTask localTask{};
+	TPlanSignature signature;
+	std::vector<size_t> localPropertyIds(task.PropertiesCount, NONE);
+	std::vector<size_t> usedPropertyIds;
+	for (auto &component : components) {
+		std::ranges::sort(component.ConstraintIds);
+		auto [begin, end] = std::ranges::unique(component.ConstraintIds);
+		component.ConstraintIds.erase(begin, end);
+
+		if (component.CSMIds.size() == 1) {
+			// the only way to satisfy a lone single-method constraint
+			solution.CSMIds.push_back(component.CSMIds[0]);
+			continue;
+		}
+
+		signature.clear();
+		for (const auto &constraintId : component.ConstraintIds) {
+			signature.push_back(constraintKeys[constraintId]);
+		}
+
+		const TSolution *local = cache.Find(signature);
+		std::optional<TSolution> solved;
+		if (!local) {
+			localTask.CSMs.clear();
+			for (const auto &csmId : component.CSMIds) {
+				const auto &csm = task.CSMs[csmId];
+				auto localIds = [&](const std::vector<size_t> &ids) {
+					std::vector<size_t> result;
+					result.reserve(ids.size());
+					for (const auto &id : ids) {
+						if (localPropertyIds[id] == NONE) {
+							localPropertyIds[id] = usedPropertyIds.size();
+							usedPropertyIds.push_back(id);
+						}
+						result.push_back(localPropertyIds[id]);
+					}
+					return result;
+				};
+				auto rank = std::ranges::lower_bound(component.ConstraintIds, csm.ConstraintId) - component.ConstraintIds.begin();
+				localTask.CSMs.push_back({
+				    .ConstraintId = static_cast<size_t>(rank),
+				    .InputPropertyIds = localIds(csm.InputPropertyIds),
+				    .OutputPropertyIds = localIds(csm.OutputPropertyIds),
+				});
+			}
+			localTask.PropertiesCount = usedPropertyIds.size();
+			localTask.ConstraintsCount = component.ConstraintIds.size();
+			for (const auto &id : usedPropertyIds) {
+				localPropertyIds[id] = NONE;
+			}
+			usedPropertyIds.clear();
+
+			solved = solver.TrySolve(localTask);
+			if (!solved) {
+				return std::nullopt;
+			}
+			cache.Insert(signature, *solved);
+			local = &*solved;
+		}
+
+		for (const auto &localCSMId : local->CSMIds) {
+			solution.CSMIds.push_back(component.CSMIds[localCSMId]);
+		}
+	}
+
+	// all current components were just used, the entries of components that
+	// no longer exist are evicted first
+	cache.SetCapacity(capacity);
+
+	return solution;
+}
+
+}  // namespace NPropertyModels::NSolver
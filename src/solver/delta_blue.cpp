@@ -0,0 +1,522 @@
+#include "delta_blue.h"
+
+#define NPROPERTY_MODELS_IMPL_ALLOWED
+#include "internal/solver/plan_cache.h"
+#undef NPROPERTY_MODELS_IMPL_ALLOWED
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace NPropertyModels::NSolver {
+
+namespace {
+
+constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+struct TMethod {
+	std::vector<uint32_t> InputPropertyIds;
+	uint32_t OutputPropertyId;
+};
+
+struct TConstraintState {
+	// identifies the constraint between tasks
+	TPlanSignature Signature;
+	size_t SignatureHash = 0;
+	// the last task it was found in
+	size_t TaskNumber = 0;
+
+	// CSMs in the order of the task, the signature keeps it
+	std::vector<TMethod> Methods;
+	// distinct properties of all methods
+	std::vector<uint32_t> PropertyIds;
+	size_t Strength = 0;
+	uint32_t Chosen = NONE;
+	bool Alive = false;
+	bool InGraph = false;
+};
+
+// the CSMs of a constraint
+void MakeSignature(const TTask &task, std::span<const uint32_t> csmIds, TPlanSignature &signature) {
+	signature.clear();
+	for (const auto &csmId : csmIds) {
+		const auto &csm = task.CSMs[csmId];
+		signature.push_back(csm.InputPropertyIds.size());
+		signature.insert(signature.end(), csm.InputPropertyIds.begin(), csm.InputPropertyIds.end());
+		signature.push_back(csm.OutputPropertyIds.front());
+	}
+}
+
+// representative of the set of the item, halves the paths on the way
+uint32_t FindRoot(std::vector<uint32_t> &parents, uint32_t item) {
+	while (parents[item] != item) {
+		parents[item] = parents[parents[item]];
+		item = parents[item];
+	}
+	return item;
+}
+
+// positions of a longest increasing subsequence
+std::vector<size_t> GetLongestIncreasing(const std::vector<size_t> &values) {
+	std::vector<size_t> tails;
+	std::vector<size_t> previous(values.size(), NONE);
+	for (size_t i = 0; i < values.size(); ++i) {
+		auto it = std::ranges::lower_bound(tails, values[i], {}, [&values](size_t position) { return values[position]; });
+		if (it != tails.begin()) {
+			previous[i] = *(it - 1);
+		}
+		if (it == tails.end()) {
+			tails.push_back(i);
+		} else {
+			*it = i;
+		}
+	}
+
+	std::vector<size_t> result;
+	for (size_t i = tails.empty() ? NONE : tails.back(); i != NONE; i = previous[i]) {
+		result.push_back(i);
+	}
+	std::ranges::reverse(result);
+	return result;
+}
+
+}  // namespace
+
+// Constraint ids of a task are its strengths, the strongest first. Every
+// property has a walkabout strength: the weakest strength on the path that
+// determines it, i.e. what would have to be retracted to change it. It is
+// kept as the constraint it comes from, so strengths can be renumbered
+// without touching properties as long as their order is kept.
+class TDeltaBlueSolver::TImpl {
+public:
+	std::optional<TSolution> Solve(const TTask &task) {
+		std::lock_guard lock(Mutex_);
+		++TaskNumber_;
+
+		// CSMs of the constraint with id i are
+		// csmIds[csmBegins[i]], ..., csmIds[csmBegins[i + 1] - 1]
+		std::vector<uint32_t> csmBegins(task.ConstraintsCount + 1, 0);
+		for (const auto &csm : task.CSMs) {
+			++csmBegins[csm.ConstraintId + 1];
+		}
+		std::partial_sum(csmBegins.begin(), csmBegins.end(), csmBegins.begin());
+		std::vector<uint32_t> csmIds(task.CSMs.size());
+		std::vector<uint32_t> ends(csmBegins.begin(), csmBegins.end() - 1);
+		for (size_t csmId = 0; csmId < task.CSMs.size(); ++csmId) {
+			csmIds[ends[task.CSMs[csmId].ConstraintId]++] = static_cast<uint32_t>(csmId);
+		}
+		auto getCSMIds = [&csmBegins, &csmIds](size_t constraintId) {
+			return std::span<const uint32_t>(csmIds.data() + csmBegins[constraintId], csmIds.data() + csmBegins[constraintId + 1]);
+		};
+
+		// constraints kept from the previous task
+		std::vector<uint32_t> matches(task.ConstraintsCount, NONE);
+		TPlanSignature signature;
+		for (size_t constraintId = 0; constraintId < task.ConstraintsCount; ++constraintId) {
+			MakeSignature(task, getCSMIds(constraintId), signature);
+			auto [begin, end] = Signatures_.equal_range(TPlanSignatureHash{}(signature));
+			for (auto it = begin; it != end; ++it) {
+				auto &constraint = Constraints_[it->second];
+				if (constraint.TaskNumber != TaskNumber_ && constraint.Signature == signature) {
+					constraint.TaskNumber = TaskNumber_;
+					matches[constraintId] = it->second;
+					break;
+				}
+			}
+		}
+		for (uint32_t index = 0; index < Constraints_.size(); ++index) {
+			if (Constraints_[index].Alive && Constraints_[index].TaskNumber != TaskNumber_) {
+				Destroy(index);
+			}
+		}
+
+		if (Determiners_.size() < task.PropertiesCount) {
+			Determiners_.resize(task.PropertiesCount, NONE);
+			WalkStrengths_.resize(task.PropertiesCount, NONE);
+			Marks_.resize(task.PropertiesCount, 0);
+			ConstraintsByProperty_.resize(task.PropertiesCount);
+		}
+
+		// kept constraints out of the longest run with the same relative
+		// order have moved and are inserted again with the new ones
+		std::vector<size_t> keptIds;
+		std::vector<size_t> oldStrengths;
+		for (size_t constraintId = 0; constraintId < task.ConstraintsCount; ++constraintId) {
+			if (matches[constraintId] != NONE) {
+				keptIds.push_back(constraintId);
+				oldStrengths.push_back(Constraints_[matches[constraintId]].Strength);
+			}
+		}
+		std::vector<uint8_t> moved(task.ConstraintsCount, 1);
+		for (const auto &position : GetLongestIncreasing(oldStrengths)) {
+			moved[keptIds[position]] = 0;
+		}
+		for (const auto &constraintId : keptIds) {
+			if (moved[constraintId]) {
+				Retract(matches[constraintId]);
+			}
+		}
+
+		// the relative order of the constraints in the graph is kept
+		for (const auto &constraintId : keptIds) {
+			Constraints_[matches[constraintId]].Strength = constraintId;
+		}
+
+		Indices_.assign(task.ConstraintsCount, NONE);
+		for (size_t constraintId = 0; constraintId < task.ConstraintsCount; ++constraintId) {
+			uint32_t index = matches[constraintId];
+			if (index == NONE) {
+				index = Create(task, getCSMIds(constraintId), constraintId);
+			}
+			Indices_[constraintId] = index;
+
+			if (!Constraints_[index].InGraph) {
+				AddToGraph(index);
+				IncrementalAdd(index);
+			}
+		}
+
+		return ExtractPlan(task, csmBegins, csmIds);
+	}
+
+private:
+	[[nodiscard]] size_t GetStrength(uint32_t index) const {
+		return index == NONE ? std::numeric_limits<size_t>::max() : Constraints_[index].Strength;
+	}
+
+	[[nodiscard]] bool IsStronger(uint32_t index, uint32_t otherIndex) const {
+		return GetStrength(index) < GetStrength(otherIndex);
+	}
+
+	[[nodiscard]] uint32_t GetWeakest(uint32_t index, uint32_t otherIndex) const {
+		return IsStronger(index, otherIndex) ? otherIndex : index;
+	}
+
+	[[nodiscard]] bool IsSatisfied(uint32_t index) const {
+		return Constraints_[index].Chosen != NONE;
+	}
+
+	[[nodiscard]] const TMethod &GetChosen(uint32_t index) const {
+		const auto &constraint = Constraints_[index];
+		return constraint.Methods[constraint.Chosen];
+	}
+
+	uint32_t Create(const TTask &task, std::span<const uint32_t> csmIds, size_t strength) {
+		uint32_t index;
+		if (FreeIndices_.empty()) {
+			index = static_cast<uint32_t>(Constraints_.size());
+			Constraints_.emplace_back();
+		} else {
+			index = FreeIndices_.back();
+			FreeIndices_.pop_back();
+		}
+
+		auto &constraint = Constraints_[index];
+		constraint = TConstraintState{};
+		constraint.TaskNumber = TaskNumber_;
+		constraint.Strength = strength;
+		constraint.Alive = true;
+		MakeSignature(task, csmIds, constraint.Signature);
+		constraint.SignatureHash = TPlanSignatureHash{}(constraint.Signature);
+		Signatures_.emplace(constraint.SignatureHash, index);
+
+		std::unordered_set<uint32_t> propertyIds;
+		for (const auto &csmId : csmIds) {
+			const auto &csm = task.CSMs[csmId];
+			TMethod method{.InputPropertyIds = {}, .OutputPropertyId = static_cast<uint32_t>(csm.OutputPropertyIds.front())};
+			for (const auto &propertyId : csm.InputPropertyIds) {
+				if (propertyIds.insert(propertyId).second) {
+					constraint.PropertyIds.push_back(propertyId);
+				}
+				if (std::ranges::find(method.InputPropertyIds, propertyId) == method.InputPropertyIds.end()) {
+					method.InputPropertyIds.push_back(propertyId);
+				}
+			}
+			if (propertyIds.insert(method.OutputPropertyId).second) {
+				constraint.PropertyIds.push_back(method.OutputPropertyId);
+			}
+			constraint.Methods.push_back(std::move(method));
+		}
+		return index;
+	}
+
+	void Destroy(uint32_t index) {
+		if (Constraints_[index].InGraph) {
+			Retract(index);
+		}
+		auto [begin, end] = Signatures_.equal_range(Constraints_[index].SignatureHash);
+		Signatures_.erase(std::find_if(begin, end, [index](const auto &entry) { return entry.second == index; }));
+		Constraints_[index] = {};
+		FreeIndices_.push_back(index);
+	}
+
+	void AddToGraph(uint32_t index) {
+		Constraints_[index].InGraph = true;
+		for (const auto &propertyId : Constraints_[index].PropertyIds) {
+			ConstraintsByProperty_[propertyId].push_back(index);
+		}
+	}
+
+	// removes the constraint from the graph and repairs what it determined
+	void Retract(uint32_t index) {
+		auto &constraint = Constraints_[index];
+		constraint.InGraph = false;
+		for (const auto &propertyId : constraint.PropertyIds) {
+			std::erase(ConstraintsByProperty_[propertyId], index);
+		}
+		if (IsSatisfied(index)) {
+			IncrementalRemove(index);
+		}
+	}
+
+	void IncrementalAdd(uint32_t index) {
+		size_t mark = ++Mark_;
+		uint32_t overridden = Satisfy(index, mark);
+		while (overridden != NONE) {
+			overridden = Satisfy(overridden, mark);
+		}
+	}
+
+	// returns the constraint that determined the new output before
+	uint32_t Satisfy(uint32_t index, size_t mark) {
+		ChooseMethod(index, mark);
+		if (!IsSatisfied(index)) {
+			return NONE;
+		}
+
+		const auto &method = GetChosen(index);
+		for (const auto &propertyId : method.InputPropertyIds) {
+			Marks_[propertyId] = mark;
+		}
+		uint32_t outputId = method.OutputPropertyId;
+		uint32_t overridden = Determiners_[outputId];
+		if (overridden != NONE) {
+			Constraints_[overridden].Chosen = NONE;
+		}
+		Determiners_[outputId] = index;
+		Marks_[outputId] = mark;
+
+		AddPropagate(index);
+		return overridden;
+	}
+
+	// the method whose output is the weakest one that is weaker than the
+	// constraint and was not determined by this insertion
+	void ChooseMethod(uint32_t index, size_t mark) {
+		auto &constraint = Constraints_[index];
+		constraint.Chosen = NONE;
+		uint32_t weakest = index;
+		for (uint32_t methodId = 0; methodId < constraint.Methods.size(); ++methodId) {
+			uint32_t outputId = constraint.Methods[methodId].OutputPropertyId;
+			if (Marks_[outputId] != mark && IsStronger(weakest, WalkStrengths_[outputId])) {
+				weakest = WalkStrengths_[outputId];
+				constraint.Chosen = methodId;
+			}
+		}
+	}
+
+	// the output may be handed over through any other output of the
+	// constraint, the inputs of methods that are never outputs do not count
+	void Recalculate(uint32_t index) {
+		const auto &constraint = Constraints_[index];
+		uint32_t strength = index;
+		for (uint32_t methodId = 0; methodId < constraint.Methods.size(); ++methodId) {
+			if (methodId != constraint.Chosen) {
+				strength = GetWeakest(strength, WalkStrengths_[constraint.Methods[methodId].OutputPropertyId]);
+			}
+		}
+		WalkStrengths_[GetChosen(index).OutputPropertyId] = strength;
+	}
+
+	// updates walkabout strengths downstream of the satisfied constraint, the
+	// constraint graph is a forest, so the plan can not have a cycle
+	void AddPropagate(uint32_t index) {
+		std::vector<uint32_t> todo{index};
+		while (!todo.empty()) {
+			uint32_t current = todo.back();
+			todo.pop_back();
+			Recalculate(current);
+			ForEachConsumer(GetChosen(current).OutputPropertyId, [&todo](uint32_t consumer) { todo.push_back(consumer); });
+		}
+	}
+
+	void IncrementalRemove(uint32_t index) {
+		uint32_t outputId = GetChosen(index).OutputPropertyId;
+		Constraints_[index].Chosen = NONE;
+
+		std::vector<uint32_t> unsatisfied = RemovePropagateFrom(outputId);
+		std::ranges::sort(unsatisfied, [this](uint32_t lhs, uint32_t rhs) { return IsStronger(lhs, rhs); });
+		unsatisfied.erase(std::unique(unsatisfied.begin(), unsatisfied.end()), unsatisfied.end());
+		for (const auto &other : unsatisfied) {
+			if (!IsSatisfied(other)) {
+				IncrementalAdd(other);
+			}
+		}
+	}
+
+	// the property is no longer determined, returns the unsatisfied
+	// constraints that may be satisfied now
+	std::vector<uint32_t> RemovePropagateFrom(uint32_t outputId) {
+		Determiners_[outputId] = NONE;
+		WalkStrengths_[outputId] = NONE;
+
+		std::vector<uint32_t> unsatisfied;
+		std::vector<uint32_t> todo{outputId};
+		while (!todo.empty()) {
+			uint32_t propertyId = todo.back();
+			todo.pop_back();
+			for (const auto &index : ConstraintsByProperty_[propertyId]) {
+				if (!IsSatisfied(index)) {
+					unsatisfied.push_back(index);
+				}
+			}
+
+			ForEachConsumer(propertyId, [this, &todo](uint32_t consumer) {
+				Recalculate(consumer);
+				todo.push_back(GetChosen(consumer).OutputPropertyId);
+			});
+		}
+		return unsatisfied;
+	}
+
+	// calls consumer(index) for the satisfied constraints reading the
+	// property
+	template <typename TConsumer>
+	void ForEachConsumer(uint32_t propertyId, TConsumer &&consumer) const {
+		for (const auto &index : ConstraintsByProperty_[propertyId]) {
+			if (index != Determiners_[propertyId] && IsSatisfied(index)) {
+				consumer(index);
+			}
+		}
+	}
+
+	// satisfied CSMs, each one after the ones determining its inputs, and
+	// of the ready ones the strongest first, so the order does not depend
+	// on the previous tasks
+	TSolution ExtractPlan(const TTask &task, const std::vector<uint32_t> &csmBegins, const std::vector<uint32_t> &csmIds) const {
+		std::vector<uint32_t> waiting(task.ConstraintsCount, 0);
+		std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> ready;
+		for (uint32_t constraintId = 0; constraintId < task.ConstraintsCount; ++constraintId) {
+			uint32_t index = Indices_[constraintId];
+			if (!IsSatisfied(index)) {
+				continue;
+			}
+			for (const auto &propertyId : GetChosen(index).InputPropertyIds) {
+				waiting[constraintId] += Determiners_[propertyId] != NONE ? 1 : 0;
+			}
+			if (waiting[constraintId] == 0) {
+				ready.push(constraintId);
+			}
+		}
+
+		TSolution solution;
+		while (!ready.empty()) {
+			uint32_t constraintId = ready.top();
+			ready.pop();
+			uint32_t index = Indices_[constraintId];
+			solution.CSMIds.push_back(csmIds[csmBegins[constraintId] + Constraints_[index].Chosen]);
+
+			ForEachConsumer(GetChosen(index).OutputPropertyId, [this, &waiting, &ready](uint32_t consumer) {
+				size_t consumerId = Constraints_[consumer].Strength;
+				if (--waiting[consumerId] == 0) {
+					ready.push(static_cast<uint32_t>(consumerId));
+				}
+			});
+		}
+		return solution;
+	}
+
+private:
+	std::mutex Mutex_;
+
+	std::vector<TConstraintState> Constraints_;
+	std::vector<uint32_t> FreeIndices_;
+	// constraints of the previous task by the hashes of their signatures
+	std::unordered_multimap<size_t, uint32_t> Signatures_;
+	size_t TaskNumber_ = 0;
+	// constraint ids of the current task to constraints
+	std::vector<uint32_t> Indices_;
+
+	std::vector<uint32_t> Determiners_;
+	std::vector<uint32_t> WalkStrengths_;
+	std::vector<size_t> Marks_;
+	size_t Mark_ = 0;
+	std::vector<std::vector<uint32_t>> ConstraintsByProperty_;
+};
+
+TDeltaBlueSolver::TDeltaBlueSolver()
+    : Impl_(std::make_shared<TImpl>()) {
+}
+
+EApplicability TDeltaBlueSolver::IsApplicable(const TTask &task) const {
+	std::vector<std::vector<size_t>> constraintDomains(task.ConstraintsCount);
+	for (const auto &csm : task.CSMs) {
+		if (csm.ConstraintId >= task.ConstraintsCount) {
+			throw std::invalid_argument("constraint id is to large");
+		}
+		for (const auto &ids : {std::cref(csm.InputPropertyIds), std::cref(csm.OutputPropertyIds)}) {
+			for (const auto &id : ids.get()) {
+				if (id >= task.PropertiesCount) {
+					throw std::invalid_argument("property id is to large");
+				}
+			}
+		}
+		if (csm.OutputPropertyIds.size() != 1) {
+			return EApplicability::NOT_APPLICABLE;
+		}
+		if (std::ranges::find(csm.InputPropertyIds, csm.OutputPropertyIds.front()) != csm.InputPropertyIds.end()) {
+			throw std::invalid_argument("input and output properties intersect");
+		}
+
+		// every CSM of a constraint has to use all of its properties
+		std::vector<size_t> domain(csm.InputPropertyIds);
+		domain.push_back(csm.OutputPropertyIds.front());
+		std::ranges::sort(domain);
+		domain.erase(std::unique(domain.begin(), domain.end()), domain.end());
+		auto &constraintDomain = constraintDomains[csm.ConstraintId];
+		if (constraintDomain.empty()) {
+			constraintDomain = std::move(domain);
+		} else if (constraintDomain != domain) {
+			return EApplicability::NOT_APPLICABLE;
+		}
+	}
+
+	if (task.PropertiesCount + task.ConstraintsCount >= NONE) {
+		return EApplicability::NOT_APPLICABLE;
+	}
+
+	// walkabout strengths are only exact if the graph of constraints and
+	// their properties is a forest, with a cycle the plan would depend on
+	// the order of the edits
+	std::vector<uint32_t> parents(task.PropertiesCount + task.ConstraintsCount);
+	std::iota(parents.begin(), parents.end(), 0);
+	for (size_t constraintId = 0; constraintId < task.ConstraintsCount; ++constraintId) {
+		auto constraintRoot = static_cast<uint32_t>(task.PropertiesCount + constraintId);
+		for (const auto &propertyId : constraintDomains[constraintId]) {
+			uint32_t propertyRoot = FindRoot(parents, static_cast<uint32_t>(propertyId));
+			if (propertyRoot == constraintRoot) {
+				return EApplicability::NOT_APPLICABLE;
+			}
+			parents[propertyRoot] = constraintRoot;
+		}
+	}
+
+	return EApplicability::APPLICABLE;
+}
+
+std::optional<TSolution> TDeltaBlueSolver::TrySolve(const TTask &task) const {
+	if (IsApplicable(task) != EApplicability::APPLICABLE) {
+		return std::nullopt;
+	}
+
+	return Impl_->Solve(task);
+}
+
+}  // namespace NPropertyModels::NSolver
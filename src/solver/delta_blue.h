@@ -0,0 +1,39 @@
+#pragma once
+
+#define NPROPERTY_MODELS_IMPL_ALLOWED
+#include "internal/solver/solver.h"
+#undef NPROPERTY_MODELS_IMPL_ALLOWED
+
+#include <memory>
+
+namespace NPropertyModels::NSolver {
+
+// Incremental solver for tasks whose CSMs have a single output and whose
+// constraints and properties form a forest, based on walkabout strengths
+// (DeltaBlue). The plan of the previous task is kept and the next task is
+// compared to it: constraints are recognized by their CSMs, so only added
+// and removed constraints, and the ones whose strength moved relative to the
+// rest, are retracted or inserted and only the paths they affect are
+// repaired.
+//
+// Copies share the kept plan, use one solver per model to reuse it.
+//
+// An experiment, not part of the library: GetSolver does not use it and it
+// is only built into the tests and benchmarks. Most models have cycles, two
+// constraints over the same properties are enough, and on those it is not
+// applicable. Solving them would mean leaving the weakest constraints of a
+// cycle unsatisfied, which walkabout strengths can not express.
+class TDeltaBlueSolver {
+public:
+	TDeltaBlueSolver();
+
+	[[nodiscard]] EApplicability IsApplicable(const TTask &task) const;
+
+	[[nodiscard]] std::optional<TSolution> TrySolve(const TTask &task) const;
+
+private:
+	class TImpl;
+	std::shared_ptr<TImpl> Impl_;
+};
+
+}  // namespace NPropertyModels::NSolver
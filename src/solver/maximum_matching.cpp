@@ -1,5 +1,8 @@
 #include "maximum_matching.h"
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
 #include <unordered_set>
 
 namespace NPropertyModels::NSolver {
@@ -22,61 +25,165 @@ struct TGraph {
 	std::vector<TEdge> Edges;
 };
 
-// kuhn O(VE)
+constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+// Returns the ids of the matched edges. Vertices of the first part are in
+// priority order: the first one is the strongest, and a vertex is matched
+// if it can be matched together with all stronger matched ones, as with
+// Kuhn's algorithm visiting them in order.
+//
+// Hopcroft-Karp O(E sqrt(V)) finds a maximum matching, then a stronger
+// unmatched vertex takes the place of a weaker matched one it reaches
+// through an alternating path. Vertices a failed search visited can never
+// reach a weaker matched vertex again, so they are skipped from then on.
 [[nodiscard]] std::vector<size_t> GetMaxCostMatching(
     const TBipartiteGraph &graph
 ) {
-	std::vector<std::vector<size_t>> edgeIds(graph.FirstPartCount);
-	for (size_t id = 0; id < graph.Edges.size(); ++id) {
-		const TEdge &edge = graph.Edges[id];
+	const auto &edges = graph.Edges;
 
-		edgeIds[edge.FromId].push_back(id);
+	// the edges of vertex u are edgeIds[begins[u]], ...,
+	// edgeIds[begins[u + 1] - 1] in the order of the graph
+	std::vector<size_t> begins(graph.FirstPartCount + 1, 0);
+	for (const auto &edge : edges) {
+		++begins[edge.FromId + 1];
+	}
+	std::partial_sum(begins.begin(), begins.end(), begins.begin());
+	std::vector<size_t> edgeIds(edges.size());
+	{
+		std::vector<size_t> ends(begins.begin(), begins.end() - 1);
+		for (size_t id = 0; id < edges.size(); ++id) {
+			edgeIds[ends[edges[id].FromId]++] = id;
+		}
 	}
 
-	std::vector<bool> included(graph.FirstPartCount);
-	std::vector<size_t> choosenEdge(graph.SecondPartCount, -1);
+	std::vector<size_t> matchedEdge(graph.FirstPartCount, NONE);
+	std::vector<size_t> choosenEdge(graph.SecondPartCount, NONE);
+	auto getMatched = [&](size_t v) -> size_t {
+		return choosenEdge[v] == NONE ? NONE : edges[choosenEdge[v]].FromId;
+	};
 
-	std::vector<bool> visited(graph.FirstPartCount);
-	auto dfsImpl = [&edges = std::as_const(graph.Edges),
-	                &edgeIds = std::as_const(edgeIds),
-	                &included,
-	                &choosenEdge,
-	                &visited](const auto &self, size_t u) -> bool {
-		if (visited[u]) {
-			return false;
+	// the current edge of every vertex on the stack, the path from the
+	// bottom of the stack is made alternating along them
+	std::vector<size_t> nextEdge(graph.FirstPartCount);
+	std::vector<size_t> stack;
+	auto augment = [&]() {
+		for (const auto &u : stack) {
+			size_t id = edgeIds[nextEdge[u]];
+			matchedEdge[u] = id;
+			choosenEdge[edges[id].ToId] = id;
 		}
-		visited[u] = true;
+	};
 
-		for (const auto &id : edgeIds[u]) {
-			size_t v = edges[id].ToId;
+	std::vector<size_t> distances(graph.FirstPartCount);
+	std::vector<size_t> queue;
+	auto buildLayers = [&]() -> bool {
+		queue.clear();
+		for (size_t u = 0; u < graph.FirstPartCount; ++u) {
+			distances[u] = matchedEdge[u] == NONE ? 0 : NONE;
+			if (distances[u] == 0) {
+				queue.push_back(u);
+			}
+		}
 
-			if (choosenEdge[v] == -1 ||
-			    self(self, edges[choosenEdge[v]].FromId)) {
-				choosenEdge[v] = id;
-				return true;
+		// only shortest augmenting paths are used
+		size_t limit = NONE;
+		for (size_t head = 0; head < queue.size(); ++head) {
+			size_t u = queue[head];
+			if (distances[u] >= limit) {
+				break;
+			}
+			for (size_t i = begins[u]; i < begins[u + 1]; ++i) {
+				size_t w = getMatched(edges[edgeIds[i]].ToId);
+				if (w == NONE) {
+					limit = distances[u];
+				} else if (distances[w] == NONE) {
+					distances[w] = distances[u] + 1;
+					queue.push_back(w);
+				}
 			}
 		}
+		return limit != NONE;
+	};
+	auto findAugmenting = [&](size_t root) -> bool {
+		stack.assign(1, root);
+		while (!stack.empty()) {
+			size_t u = stack.back();
+			if (nextEdge[u] == begins[u + 1]) {
+				distances[u] = NONE;
+				stack.pop_back();
+				continue;
+			}
 
+			size_t w = getMatched(edges[edgeIds[nextEdge[u]]].ToId);
+			if (w == NONE) {
+				augment();
+				return true;
+			}
+			if (distances[w] != NONE && distances[w] == distances[u] + 1) {
+				stack.push_back(w);
+				continue;
+			}
+			++nextEdge[u];
+		}
 		return false;
 	};
-	auto dfs = [&dfsImpl, &visited](size_t u) -> bool {
-		visited.assign(visited.size(), false);
-		return dfsImpl(dfsImpl, u);
-	};
 
-	size_t matchingSize = 0;
-	for (size_t i = 0; i < graph.FirstPartCount; ++i) {
-		if (included[i]) {
+	while (buildLayers()) {
+		std::copy(begins.begin(), begins.end() - 1, nextEdge.begin());
+		for (size_t u = 0; u < graph.FirstPartCount; ++u) {
+			if (matchedEdge[u] == NONE) {
+				findAugmenting(u);
+			}
+		}
+	}
+
+	std::vector<uint8_t> dead(graph.FirstPartCount, 0);
+	std::vector<size_t> visited;
+	for (size_t root = 0; root < graph.FirstPartCount; ++root) {
+		if (matchedEdge[root] != NONE || dead[root]) {
 			continue;
 		}
 
-		matchingSize += static_cast<size_t>(dfs(i));
+		stack.assign(1, root);
+		visited.assign(1, root);
+		dead[root] = 1;
+		nextEdge[root] = begins[root];
+		while (!stack.empty()) {
+			size_t u = stack.back();
+			if (nextEdge[u] == begins[u + 1]) {
+				stack.pop_back();
+				continue;
+			}
+
+			size_t w = getMatched(edges[edgeIds[nextEdge[u]]].ToId);
+			if (w == NONE || w > root) {
+				if (w != NONE) {
+					matchedEdge[w] = NONE;
+				}
+				augment();
+				break;
+			}
+			if (!dead[w]) {
+				// marked while searching, cleared if the search succeeds
+				dead[w] = 1;
+				visited.push_back(w);
+				nextEdge[w] = begins[w];
+				stack.push_back(w);
+				continue;
+			}
+			++nextEdge[u];
+		}
+
+		if (!stack.empty()) {
+			for (const auto &u : visited) {
+				dead[u] = 0;
+			}
+		}
 	}
 
 	std::vector<size_t> result;
-	result.reserve(matchingSize);
 	for (const auto &id : choosenEdge) {
-		if (id == -1) {
+		if (id == NONE) {
 			continue;
 		}
 
@@ -194,6 +301,7 @@ std::optional<TSolution> TMaximumMatchingSolver::TrySolve(
 	TBipartiteGraph matchingGraph{
 	    .FirstPartCount = task.ConstraintsCount,
 	    .SecondPartCount = task.PropertiesCount,
+	    .Edges{},
 	};
 	matchingGraph.Edges.reserve(task.CSMs.size());
 	for (const auto &csm : task.CSMs) {
@@ -220,6 +328,7 @@ std::optional<TSolution> TMaximumMatchingSolver::TrySolve(
 	// check solution before reporting it;
 	TGraph solutionGraph{
 	    .VerticesCount = task.PropertiesCount + task.ConstraintsCount,
+	    .Edges{},
 	};
 	for (const auto &id : solution.CSMIds) {
 		const auto &csm = task.CSMs[id];
@@ -0,0 +1,80 @@
+#define NPROPERTY_MODELS_IMPL_ALLOWED
+#include "internal/solver/plan_cache.h"
+#undef NPROPERTY_MODELS_IMPL_ALLOWED
+
+namespace NPropertyModels::NSolver {
+
+size_t TPlanSignatureHash::operator()(const TPlanSignature &signature) const {
+	// FNV-1a over the whole signature
+	size_t hash = 14695981039346656037ull;
+	for (const auto &value : signature) {
+		hash ^= value;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+TPlanCache::TPlanCache(size_t capacity)
+    : Capacity_(capacity) {
+}
+
+const TSolution *TPlanCache::Find(const TPlanSignature &signature) {
+	auto it = Index_.find(signature);
+	if (it == Index_.end()) {
+		++Misses_;
+		return nullptr;
+	}
+
+	++Hits_;
+	Entries_.splice(Entries_.begin(), Entries_, it->second);
+	return &it->second->second;
+}
+
+bool TPlanCache::Contains(const TPlanSignature &signature) const {
+	return Index_.contains(signature);
+}
+
+void TPlanCache::Insert(const TPlanSignature &signature, const TSolution &solution) {
+	if (Capacity_ == 0) {
+		return;
+	}
+
+	auto it = Index_.find(signature);
+	if (it != Index_.end()) {
+		it->second->second = solution;
+		Entries_.splice(Entries_.begin(), Entries_, it->second);
+		return;
+	}
+
+	Entries_.emplace_front(signature, solution);
+	Index_.emplace(signature, Entries_.begin());
+	Shrink();
+}
+
+void TPlanCache::SetCapacity(size_t capacity) {
+	Capacity_ = capacity;
+	Shrink();
+}
+
+void TPlanCache::Clear() {
+	Entries_.clear();
+	Index_.clear();
+}
+
+TPlanCacheStats TPlanCache::GetStats() const {
+	return {
+	    .Hits = Hits_,
+	    .Misses = Misses_,
+	    .Size = Entries_.size(),
+	    .Capacity = Capacity_,
+	};
+}
+
+void TPlanCache::Shrink() {
+	while (Entries_.size() > Capacity_) {
+		Index_.erase(Entries_.back().first);
+		Entries_.pop_back();
+	}
+}
+
+}  // namespace NPropertyModels::NSolver
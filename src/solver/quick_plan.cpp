@@ -1,250 +1,333 @@
 #include "quick_plan.h"
 
-#include <set>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
 #include <unordered_set>
 
 namespace NPropertyModels::NSolver {
 
 namespace {
 
-template <typename TKey, typename TValue>
-class TBidirectionalMap {
-public:
-	const TValue &operator[](const TKey &key) const {
-		return KeyToValue_.at(key);
-	}
+// compressed sparse rows, the items of row i are
+// Items[Begins[i]], ..., Items[Begins[i + 1] - 1]
+struct TAdjacency {
+	std::vector<uint32_t> Begins;
+	std::vector<uint32_t> Items;
 
-	void Insert(const TKey &key, const TValue &value) {
-		Erase(key);
-		KeyToValue_[key] = value;
-		ValueToKeys_[value].insert(key);
+	[[nodiscard]] std::span<const uint32_t> operator[](size_t row) const {
+		return {Items.data() + Begins[row], Items.data() + Begins[row + 1]};
 	}
+};
+
+// forEach(emit) has to call emit(row, item) for every item, it is called
+// twice: to count the items of every row and to fill them in
+template <typename TForEach>
+[[nodiscard]] TAdjacency MakeAdjacency(size_t rowsCount, TForEach &&forEach) {
+	TAdjacency adjacency;
+	adjacency.Begins.assign(rowsCount + 1, 0);
+	forEach([&adjacency](size_t row, size_t) { ++adjacency.Begins[row + 1]; });
+	std::partial_sum(adjacency.Begins.begin(), adjacency.Begins.end(), adjacency.Begins.begin());
+
+	adjacency.Items.resize(adjacency.Begins.back());
+	std::vector<uint32_t> ends(adjacency.Begins.begin(), adjacency.Begins.end() - 1);
+	forEach([&adjacency, &ends](size_t row, size_t item) { adjacency.Items[ends[row]++] = static_cast<uint32_t>(item); });
+	return adjacency;
+}
+
+// The part of the task that does not change while solving it, shared by all
+// graphs the solver works on.
+struct TTopology {
+	explicit TTopology(const TTask &task)
+	    : PropertiesCount(task.PropertiesCount), ConstraintsCount(task.ConstraintsCount), CSMsCount(task.CSMs.size()) {
+		ConstraintByCSM.reserve(CSMsCount);
+		for (const auto &csm : task.CSMs) {
+			ConstraintByCSM.push_back(static_cast<uint32_t>(csm.ConstraintId));
+		}
 
-	void Erase(const TKey &key) {
-		auto it = KeyToValue_.find(key);
-		if (it != KeyToValue_.end()) {
-			const TValue &value = it->second;
-			auto vit = ValueToKeys_.find(value);
-			if (vit != ValueToKeys_.end()) {
-				vit->second.erase(key);
-				if (vit->second.empty()) {
-					ValueToKeys_.erase(vit);
+		CSMsByConstraint = MakeAdjacency(ConstraintsCount, [&task](auto &&emit) {
+			for (size_t csmId = 0; csmId < task.CSMs.size(); ++csmId) {
+				emit(task.CSMs[csmId].ConstraintId, csmId);
+			}
+		});
+
+		// ids lists of the task may repeat properties, the graph must not
+		std::vector<size_t> marks(PropertiesCount, NONE);
+		PropertiesByConstraint = MakeAdjacency(ConstraintsCount, [&](auto &&emit) {
+			std::ranges::fill(marks, NONE);
+			for (size_t constraintId = 0; constraintId < ConstraintsCount; ++constraintId) {
+				for (const auto &csmId : CSMsByConstraint[constraintId]) {
+					const auto &csm = task.CSMs[csmId];
+					for (const auto &ids : {std::cref(csm.InputPropertyIds), std::cref(csm.OutputPropertyIds)}) {
+						for (const auto &propertyId : ids.get()) {
+							if (marks[propertyId] != constraintId) {
+								marks[propertyId] = constraintId;
+								emit(constraintId, propertyId);
+							}
+						}
+					}
 				}
 			}
-			KeyToValue_.erase(it);
-		}
+		});
+		OutputsByCSM = MakeAdjacency(CSMsCount, [&](auto &&emit) {
+			std::ranges::fill(marks, NONE);
+			for (size_t csmId = 0; csmId < CSMsCount; ++csmId) {
+				for (const auto &propertyId : task.CSMs[csmId].OutputPropertyIds) {
+					if (marks[propertyId] != csmId) {
+						marks[propertyId] = csmId;
+						emit(csmId, propertyId);
+					}
+				}
+			}
+		});
+		WritersByProperty = MakeAdjacency(PropertiesCount, [this](auto &&emit) {
+			for (size_t csmId = 0; csmId < CSMsCount; ++csmId) {
+				for (const auto &propertyId : OutputsByCSM[csmId]) {
+					emit(propertyId, csmId);
+				}
+			}
+		});
+	}
+
+	static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+	size_t PropertiesCount;
+	size_t ConstraintsCount;
+	size_t CSMsCount;
+	std::vector<uint32_t> ConstraintByCSM;
+	TAdjacency CSMsByConstraint;
+	// distinct properties of all CSMs of the constraint
+	TAdjacency PropertiesByConstraint;
+	TAdjacency OutputsByCSM;
+	// CSMs having the property as an output
+	TAdjacency WritersByProperty;
+};
+
+// Items grouped by degree. Items of a degree below the listed limit are
+// kept in intrusive doubly linked lists, one per degree, so any item of such
+// a degree is found and the degree of an item is changed in constant time.
+// Higher degrees are only counted, the sieve never looks for them.
+class TDegreeBuckets {
+public:
+	TDegreeBuckets(size_t itemsCount, uint32_t listedDegrees)
+	    : Heads_(listedDegrees, NONE), Degrees_(itemsCount, NONE), Previous_(itemsCount, NONE), Next_(itemsCount, NONE) {
+	}
+
+	[[nodiscard]] bool Contains(size_t item) const {
+		return Degrees_[item] != NONE;
+	}
+
+	void Insert(size_t item, uint32_t degree) {
+		Degrees_[item] = degree;
+		Link(item);
+	}
+
+	void Erase(size_t item) {
+		Unlink(item);
+		Degrees_[item] = NONE;
 	}
 
-	[[nodiscard]] bool Contains(const TKey &key) const {
-		return KeyToValue_.contains(key);
+	void Increment(size_t item) {
+		Unlink(item);
+		++Degrees_[item];
+		Link(item);
 	}
 
-	[[nodiscard]] bool ContainsValue(const TValue &value) const {
-		return ValueToKeys_.contains(value);
+	void Decrement(size_t item) {
+		Unlink(item);
+		--Degrees_[item];
+		Link(item);
 	}
 
-	[[nodiscard]] std::unordered_set<TKey> Keys(const TValue &value) const {
-		auto it = ValueToKeys_.find(value);
-		if (it != ValueToKeys_.end()) {
-			return it->second;
+	// any item of the listed degree
+	[[nodiscard]] std::optional<size_t> Find(uint32_t degree) const {
+		if (Heads_[degree] == NONE) {
+			return std::nullopt;
 		}
-		return {};
+		return Heads_[degree];
 	}
 
 private:
-	std::unordered_map<TKey, TValue> KeyToValue_;
-	std::unordered_map<TValue, std::unordered_set<TKey>> ValueToKeys_;
-};
-
-class TConstraintGraph {
-public:
-	TConstraintGraph() = default;
+	void Link(size_t item) {
+		uint32_t degree = Degrees_[item];
+		if (degree >= Heads_.size()) {
+			return;
+		}
+		Previous_[item] = NONE;
+		Next_[item] = Heads_[degree];
+		if (Next_[item] != NONE) {
+			Previous_[Next_[item]] = item;
+		}
+		Heads_[degree] = item;
+	}
 
-	explicit TConstraintGraph(const TTask &task) {
-		for (size_t constraintId = 0; constraintId < task.ConstraintsCount; ++constraintId) {
-			ConstraintIds_.insert(constraintId);
+	void Unlink(size_t item) {
+		uint32_t degree = Degrees_[item];
+		if (degree >= Heads_.size()) {
+			return;
+		}
+		if (Previous_[item] != NONE) {
+			Next_[Previous_[item]] = Next_[item];
+		} else {
+			Heads_[degree] = Next_[item];
 		}
-		for (size_t propertyId = 0; propertyId < task.PropertiesCount; ++propertyId) {
-			PropertyIdToDegree_.Insert(propertyId, 0);
-			PropertyIdToCSMs_.insert({propertyId, {}});
+		if (Next_[item] != NONE) {
+			Previous_[Next_[item]] = Previous_[item];
 		}
+	}
 
-		std::vector<std::unordered_set<size_t>> propertyToConstraints(task.PropertiesCount);
+private:
+	static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
 
-		for (size_t csmId = 0; csmId < task.CSMs.size(); ++csmId) {
-			const auto &csm = task.CSMs[csmId];
-			CSMIdToConstraintId_.Insert(csmId, csm.ConstraintId);
-			CSMIdToOutputDegree_.Insert(csmId, csm.OutputPropertyIds.size());
-			CSMIdToInputPropertyIds_[csmId] = {};
-			CSMIdToOutputPropertyIds_[csmId] = {};
+	// first item of every listed degree
+	std::vector<uint32_t> Heads_;
+	std::vector<uint32_t> Degrees_;
+	std::vector<uint32_t> Previous_;
+	std::vector<uint32_t> Next_;
+};
 
-			for (size_t propertyId : csm.InputPropertyIds) {
-				propertyToConstraints[propertyId].insert(csm.ConstraintId);
-				PropertyIdToCSMs_[propertyId].insert(csmId);
-				CSMIdToInputPropertyIds_[csmId].insert(propertyId);
-			}
-			for (size_t propertyId : csm.OutputPropertyIds) {
-				propertyToConstraints[propertyId].insert(csm.ConstraintId);
-				PropertyIdToCSMs_[propertyId].insert(csmId);
-				CSMIdToOutputPropertyIds_[csmId].insert(propertyId);
-			}
+// A subset of the constraints of the task on flat arrays indexed by id.
+// Removed properties no longer count as outputs. The degree of a property
+// is the number of present constraints using it.
+class TConstraintGraph {
+public:
+	// all constraints of the topology are present
+	explicit TConstraintGraph(const TTopology &topology)
+	    : TConstraintGraph(topology, nullptr) {
+		for (size_t constraintId = 0; constraintId < topology.ConstraintsCount; ++constraintId) {
+			AddConstraint(constraintId);
 		}
+	}
 
-		for (size_t propertyId = 0; propertyId < task.PropertiesCount; ++propertyId) {
-			PropertyIdToDegree_.Insert(propertyId, propertyToConstraints[propertyId].size());
-		}
+	// no constraints, but the same properties removed as in the other graph
+	[[nodiscard]] TConstraintGraph MakeEmpty() const {
+		return TConstraintGraph(*Topology_, this);
 	}
 
-	void RemoveProperty(size_t propertyId) {
-		if (!PropertyIdToDegree_.Contains(propertyId)) {
-			throw std::runtime_error("Property was already removed");
+	void AddConstraint(size_t constraintId) {
+		if (ConstraintPresent_[constraintId]) {
+			throw std::runtime_error("Constraint already present in this graph");
 		}
-		PropertyIdToDegree_.Erase(propertyId);
+		ConstraintPresent_[constraintId] = 1;
 
-		for (size_t csmId : PropertyIdToCSMs_[propertyId]) {
-			CSMIdToInputPropertyIds_[csmId].erase(propertyId);
-			if (CSMIdToOutputPropertyIds_[csmId].erase(propertyId)) {
-				CSMIdToOutputDegree_.Insert(csmId, CSMIdToOutputDegree_[csmId] - 1);
+		for (const auto &propertyId : Topology_->PropertiesByConstraint[constraintId]) {
+			if (PropertyDegrees_.Contains(propertyId)) {
+				PropertyDegrees_.Increment(propertyId);
 			}
 		}
-		PropertyIdToCSMs_.erase(propertyId);
+		for (const auto &csmId : Topology_->CSMsByConstraint[constraintId]) {
+			uint32_t degree = 0;
+			for (const auto &propertyId : Topology_->OutputsByCSM[csmId]) {
+				degree += PropertyDegrees_.Contains(propertyId) ? 1 : 0;
+			}
+			OutputDegrees_.Insert(csmId, degree);
+			++CSMsCount_;
+		}
 	}
 
 	void RemoveConstraint(size_t constraintId) {
-		if (!ConstraintIds_.contains(constraintId)) {
+		if (!ConstraintPresent_[constraintId]) {
 			throw std::runtime_error("Constraint was already removed");
 		}
+		ConstraintPresent_[constraintId] = 0;
 
-		ConstraintIds_.erase(constraintId);
-
-		std::unordered_set<size_t> removedPropertyLinks;
-		auto csmIds = CSMIdToConstraintId_.Keys(constraintId);
-		for (size_t csmId : csmIds) {
-			for (size_t propertyId : CSMIdToInputPropertyIds_[csmId]) {
-				PropertyIdToCSMs_[propertyId].erase(csmId);
-				removedPropertyLinks.insert(propertyId);
+		for (const auto &propertyId : Topology_->PropertiesByConstraint[constraintId]) {
+			if (PropertyDegrees_.Contains(propertyId)) {
+				PropertyDegrees_.Decrement(propertyId);
 			}
-			CSMIdToInputPropertyIds_.erase(csmId);
-
-			for (size_t propertyId : CSMIdToOutputPropertyIds_[csmId]) {
-				PropertyIdToCSMs_[propertyId].erase(csmId);
-				removedPropertyLinks.insert(propertyId);
-			}
-			CSMIdToOutputPropertyIds_.erase(csmId);
-
-			CSMIdToConstraintId_.Erase(csmId);
-			CSMIdToOutputDegree_.Erase(csmId);
 		}
-
-		for (const auto &propertyId : removedPropertyLinks) {
-			PropertyIdToDegree_.Insert(propertyId, PropertyIdToDegree_[propertyId] - 1);
+		for (const auto &csmId : Topology_->CSMsByConstraint[constraintId]) {
+			OutputDegrees_.Erase(csmId);
+			--CSMsCount_;
 		}
 	}
 
-	void CopyConstraintFrom(const TConstraintGraph &other, size_t constraintId) {
-		if (ConstraintIds_.contains(constraintId)) {
-			throw std::runtime_error("Constraint already present in this graph");
-		}
-		ConstraintIds_.insert(constraintId);
-
-		std::unordered_set<size_t> addedPropertyLinks;
-
-		auto csmIds = other.CSMIdToConstraintId_.Keys(constraintId);
-		for (size_t csmId : csmIds) {
-			if (CSMIdToConstraintId_.Contains(csmId)) {
-				throw std::runtime_error("CSM already present in this graph");
-			}
-			CSMIdToConstraintId_.Insert(csmId, constraintId);
-
-			CSMIdToOutputDegree_.Insert(csmId, other.CSMIdToOutputDegree_[csmId]);
-
-			CSMIdToInputPropertyIds_[csmId] = other.CSMIdToInputPropertyIds_.at(csmId);
-			CSMIdToOutputPropertyIds_[csmId] = other.CSMIdToOutputPropertyIds_.at(csmId);
+	// the property is no longer tombstoned, present constraints using it are
+	// not counted, so this has to be done before they are added
+	void RestoreProperty(size_t propertyId) {
+		PropertyDegrees_.Insert(propertyId, 0);
+	}
 
-			for (size_t propertyId : CSMIdToInputPropertyIds_[csmId]) {
-				if (!PropertyIdToDegree_.Contains(propertyId)) {
-					PropertyIdToDegree_.Insert(propertyId, 0);
-					PropertyIdToCSMs_.insert({propertyId, {}});
-				}
-				addedPropertyLinks.insert(propertyId);
-				PropertyIdToCSMs_[propertyId].insert(csmId);
-			}
-			for (size_t propertyId : CSMIdToOutputPropertyIds_[csmId]) {
-				if (!PropertyIdToDegree_.Contains(propertyId)) {
-					PropertyIdToDegree_.Insert(propertyId, 0);
-					PropertyIdToCSMs_.insert({propertyId, {}});
-				}
-				addedPropertyLinks.insert(propertyId);
-				PropertyIdToCSMs_[propertyId].insert(csmId);
-			}
+	void RemoveProperty(size_t propertyId) {
+		if (!PropertyDegrees_.Contains(propertyId)) {
+			throw std::runtime_error("Property was already removed");
 		}
+		PropertyDegrees_.Erase(propertyId);
 
-		for (const auto &propertyId : addedPropertyLinks) {
-			PropertyIdToDegree_.Insert(propertyId, PropertyIdToDegree_[propertyId] + 1);
+		for (const auto &csmId : Topology_->WritersByProperty[propertyId]) {
+			if (OutputDegrees_.Contains(csmId)) {
+				OutputDegrees_.Decrement(csmId);
+			}
 		}
 	}
 
 	[[nodiscard]] bool HasCSMs() const {
-		return !CSMIdToInputPropertyIds_.empty();
+		return CSMsCount_ > 0;
 	}
 
-	[[nodiscard]] std::set<size_t> GetConstraintIds() const {
-		return {ConstraintIds_.begin(), ConstraintIds_.end()};
+	[[nodiscard]] bool IsConstraintPresent(size_t constraintId) const {
+		return ConstraintPresent_[constraintId];
 	}
 
-	[[nodiscard]] size_t GetConstraintIdByCSM(size_t csmId) const {
-		return CSMIdToConstraintId_[csmId];
+	[[nodiscard]] bool IsPropertyRemoved(size_t propertyId) const {
+		return !PropertyDegrees_.Contains(propertyId);
 	}
 
-	[[nodiscard]] bool HasPropertyWithDegree(size_t degree) const {
-		return PropertyIdToDegree_.ContainsValue(degree);
+	[[nodiscard]] size_t GetConstraintIdByCSM(size_t csmId) const {
+		return Topology_->ConstraintByCSM[csmId];
 	}
 
-	[[nodiscard]] size_t GetPropertyWithDegree(size_t degree) const {
-		auto s = PropertyIdToDegree_.Keys(degree);
-		if (s.empty()) {
-			throw std::out_of_range("No property with given degree");
-		}
-		return *s.begin();
+	// a property used by a single constraint, which can therefore output it
+	[[nodiscard]] std::optional<size_t> FindFreeProperty() const {
+		return PropertyDegrees_.Find(1);
 	}
 
-	[[nodiscard]] bool HasCSMWithOutputDegree(size_t degree) const {
-		return CSMIdToOutputDegree_.ContainsValue(degree);
+	// a CSM with all outputs removed
+	[[nodiscard]] std::optional<size_t> FindReadyCSM() const {
+		return OutputDegrees_.Find(0);
 	}
 
-	[[nodiscard]] size_t GetCSMWithOutputDegree(size_t degree) const {
-		auto s = CSMIdToOutputDegree_.Keys(degree);
-		if (s.empty()) {
-			throw std::out_of_range("No CSM with given output degree");
+private:
+	// properties removed in the other graph are removed, if there is one
+	TConstraintGraph(const TTopology &topology, const TConstraintGraph *other)
+	    : Topology_(&topology),
+	      ConstraintPresent_(topology.ConstraintsCount, 0),
+	      PropertyDegrees_(topology.PropertiesCount, 2),
+	      OutputDegrees_(topology.CSMsCount, 1) {
+		for (size_t propertyId = 0; propertyId < topology.PropertiesCount; ++propertyId) {
+			if (!other || !other->IsPropertyRemoved(propertyId)) {
+				PropertyDegrees_.Insert(propertyId, 0);
+			}
 		}
-		return *s.begin();
 	}
 
 private:
-	std::unordered_set<size_t> ConstraintIds_;
-	TBidirectionalMap<size_t, size_t> PropertyIdToDegree_;
-	TBidirectionalMap<size_t, size_t> CSMIdToOutputDegree_;
-	TBidirectionalMap<size_t, size_t> CSMIdToConstraintId_;
-	std::unordered_map<size_t, std::unordered_set<size_t>> PropertyIdToCSMs_;
-	std::unordered_map<size_t, std::unordered_set<size_t>> CSMIdToInputPropertyIds_;
-	std::unordered_map<size_t, std::unordered_set<size_t>> CSMIdToOutputPropertyIds_;
+	const TTopology *Topology_;
+	std::vector<uint8_t> ConstraintPresent_;
+	// removed properties are not in the buckets
+	TDegreeBuckets PropertyDegrees_;
+	// outputs that are not removed, only CSMs of present constraints are in
+	// the buckets
+	TDegreeBuckets OutputDegrees_;
+	size_t CSMsCount_ = 0;
 };
 
 std::vector<size_t> SieveDown(TConstraintGraph &graph) {
 	std::vector<size_t> result;
 
 	while (graph.HasCSMs()) {
-		if (graph.HasPropertyWithDegree(1u)) {
-			size_t propertyId = graph.GetPropertyWithDegree(1u);
-			graph.RemoveProperty(propertyId);
+		if (auto propertyId = graph.FindFreeProperty()) {
+			graph.RemoveProperty(*propertyId);
 			continue;
 		}
 
-		if (graph.HasCSMWithOutputDegree(0u)) {
-			size_t csmId = graph.GetCSMWithOutputDegree(0u);
-			size_t constraintId = graph.GetConstraintIdByCSM(csmId);
-			graph.RemoveConstraint(constraintId);
-			result.push_back(csmId);
+		if (auto csmId = graph.FindReadyCSM()) {
+			graph.RemoveConstraint(graph.GetConstraintIdByCSM(*csmId));
+			result.push_back(*csmId);
 			continue;
 		}
 
@@ -254,27 +337,195 @@ std::vector<size_t> SieveDown(TConstraintGraph &graph) {
 	return result;
 }
 
-std::vector<size_t> SieveUp(TConstraintGraph &graph) {
-	std::vector<size_t> result;
-	TConstraintGraph preGraph;
-	TConstraintGraph postGraph;
+// Strength ordered insertion: constraints are added from the strongest one
+// and kept if they can be planned together with the ones kept before. Kept
+// constraints stay sieved down. Each sieve step depends on earlier ones:
+// removing a property on the constraints using it having been removed,
+// removing a constraint on the outputs of its CSM having been removed. A
+// new constraint invalidates the removals of its properties and everything
+// depending on them, only that region is retracted and sieved again.
+class TIncrementalSieve {
+public:
+	// the graph left by the first sieve, its removed properties are never
+	// used by the plan
+	TIncrementalSieve(const TTopology &topology, const TConstraintGraph &graph)
+	    : Topology_(topology),
+	      Graph_(graph.MakeEmpty()),
+	      PropertyTimes_(topology.PropertiesCount, 0),
+	      ConstraintTimes_(topology.ConstraintsCount, 0),
+	      ChosenCSMs_(topology.ConstraintsCount, 0) {
+	}
 
-	for (const auto &constraint : graph.GetConstraintIds()) {
-		TConstraintGraph newPreGraph = preGraph;
-		newPreGraph.CopyConstraintFrom(graph, constraint);
+	// returns false and leaves the plan as it was if the constraint can not
+	// be planned together with the ones added before
+	bool TryAdd(size_t constraintId) {
+		Retract(constraintId);
 
-		TConstraintGraph newPostGraph = newPreGraph;
-		std::vector<size_t> newResult = SieveDown(newPostGraph);
+		for (const auto &[propertyId, time] : RetractedProperties_) {
+			Graph_.RestoreProperty(propertyId);
+		}
+		for (const auto &retracted : RetractedConstraints_) {
+			Graph_.AddConstraint(retracted.ConstraintId);
+		}
+		Graph_.AddConstraint(constraintId);
 
-		if (!newPostGraph.HasCSMs()) {
-			result = std::move(newResult);
-			preGraph = std::move(newPreGraph);
-			postGraph = std::move(newPostGraph);
+		bool added = Sieve();
+		if (!added) {
+			Rollback(constraintId);
 		}
+
+		RetractedProperties_.clear();
+		RetractedConstraints_.clear();
+		SievedProperties_.clear();
+		return added;
 	}
 
-	graph = postGraph;
-	return result;
+	// CSMs of the added constraints in the order they were sieved down
+	[[nodiscard]] std::vector<size_t> GetSieveOrder() const {
+		std::vector<std::pair<size_t, size_t>> timedCSMs;
+		for (size_t constraintId = 0; constraintId < Topology_.ConstraintsCount; ++constraintId) {
+			if (ConstraintTimes_[constraintId] != 0) {
+				timedCSMs.emplace_back(ConstraintTimes_[constraintId], ChosenCSMs_[constraintId]);
+			}
+		}
+		std::ranges::sort(timedCSMs);
+
+		std::vector<size_t> result;
+		result.reserve(timedCSMs.size());
+		for (const auto &[time, csmId] : timedCSMs) {
+			result.push_back(csmId);
+		}
+		return result;
+	}
+
+private:
+	struct TRetractedConstraint {
+		size_t ConstraintId;
+		size_t Time;
+		uint32_t CSMId;
+	};
+
+	// collects the sieve steps that are no longer valid with the constraint
+	// added, the graph is not changed yet
+	void Retract(size_t constraintId) {
+		auto retractProperty = [this](size_t propertyId) {
+			RetractedProperties_.emplace_back(propertyId, PropertyTimes_[propertyId]);
+			PropertyTimes_[propertyId] = 0;
+		};
+		auto retractConstraint = [this](size_t retractedId) {
+			RetractedConstraints_.push_back({retractedId, ConstraintTimes_[retractedId], ChosenCSMs_[retractedId]});
+			ConstraintTimes_[retractedId] = 0;
+		};
+
+		// properties removed before the constraint was there were used by a
+		// single constraint, now there are two
+		for (const auto &propertyId : Topology_.PropertiesByConstraint[constraintId]) {
+			if (PropertyTimes_[propertyId] != 0) {
+				retractProperty(propertyId);
+			}
+		}
+
+		size_t nextProperty = 0;
+		size_t nextConstraint = 0;
+		while (nextProperty < RetractedProperties_.size() || nextConstraint < RetractedConstraints_.size()) {
+			if (nextProperty < RetractedProperties_.size()) {
+				// the constraint writing it relied on it being free
+				size_t propertyId = RetractedProperties_[nextProperty++].first;
+				for (const auto &csmId : Topology_.WritersByProperty[propertyId]) {
+					size_t writerId = Topology_.ConstraintByCSM[csmId];
+					if (ConstraintTimes_[writerId] != 0 && ChosenCSMs_[writerId] == csmId) {
+						retractConstraint(writerId);
+					}
+				}
+				continue;
+			}
+
+			// properties removed after it relied on it being gone
+			const TRetractedConstraint &retracted = RetractedConstraints_[nextConstraint++];
+			for (const auto &propertyId : Topology_.PropertiesByConstraint[retracted.ConstraintId]) {
+				if (PropertyTimes_[propertyId] > retracted.Time) {
+					retractProperty(propertyId);
+				}
+			}
+		}
+	}
+
+	// sieves the present constraints down, returns true if all of them are
+	// removed
+	bool Sieve() {
+		while (Graph_.HasCSMs()) {
+			if (auto propertyId = Graph_.FindFreeProperty()) {
+				Graph_.RemoveProperty(*propertyId);
+				PropertyTimes_[*propertyId] = ++Time_;
+				SievedProperties_.push_back(*propertyId);
+				continue;
+			}
+
+			if (auto csmId = Graph_.FindReadyCSM()) {
+				size_t constraintId = Graph_.GetConstraintIdByCSM(*csmId);
+				Graph_.RemoveConstraint(constraintId);
+				ConstraintTimes_[constraintId] = ++Time_;
+				ChosenCSMs_[constraintId] = *csmId;
+				continue;
+			}
+
+			return false;
+		}
+		return true;
+	}
+
+	void Rollback(size_t constraintId) {
+		auto removeIfPresent = [this](size_t presentId) {
+			if (Graph_.IsConstraintPresent(presentId)) {
+				Graph_.RemoveConstraint(presentId);
+			}
+			ConstraintTimes_[presentId] = 0;
+		};
+		removeIfPresent(constraintId);
+		for (const auto &retracted : RetractedConstraints_) {
+			removeIfPresent(retracted.ConstraintId);
+		}
+
+		for (const auto &propertyId : SievedProperties_) {
+			Graph_.RestoreProperty(propertyId);
+			PropertyTimes_[propertyId] = 0;
+		}
+		for (const auto &[propertyId, time] : RetractedProperties_) {
+			Graph_.RemoveProperty(propertyId);
+			PropertyTimes_[propertyId] = time;
+		}
+		for (const auto &retracted : RetractedConstraints_) {
+			ConstraintTimes_[retracted.ConstraintId] = retracted.Time;
+			ChosenCSMs_[retracted.ConstraintId] = retracted.CSMId;
+		}
+	}
+
+private:
+	const TTopology &Topology_;
+	// all added constraints are removed from it between calls
+	TConstraintGraph Graph_;
+
+	// sieve steps are numbered from 1, 0 for properties and constraints not
+	// removed by this sieve
+	size_t Time_ = 0;
+	std::vector<size_t> PropertyTimes_;
+	std::vector<size_t> ConstraintTimes_;
+	std::vector<uint32_t> ChosenCSMs_;
+
+	// state of the current TryAdd to roll it back
+	std::vector<std::pair<size_t, size_t>> RetractedProperties_;
+	std::vector<TRetractedConstraint> RetractedConstraints_;
+	std::vector<size_t> SievedProperties_;
+};
+
+std::vector<size_t> SieveUp(const TTopology &topology, const TConstraintGraph &graph) {
+	TIncrementalSieve sieve(topology, graph);
+	for (size_t constraintId = 0; constraintId < topology.ConstraintsCount; ++constraintId) {
+		if (graph.IsConstraintPresent(constraintId)) {
+			sieve.TryAdd(constraintId);
+		}
+	}
+	return sieve.GetSieveOrder();
 }
 
 }  // namespace
@@ -341,14 +592,20 @@ std::optional<TSolution> TQuickPlanSolver::TrySolve(const TTask &task) const {
 		return std::nullopt;
 	}
 
-	TConstraintGraph graph(task);
+	if (std::max({task.PropertiesCount, task.ConstraintsCount, task.CSMs.size()}) > std::numeric_limits<uint32_t>::max()) {
+		throw std::invalid_argument("task is to large");
+	}
+
+	TTopology topology(task);
+	TConstraintGraph graph(topology);
 
 	TSolution solution{
 	    .CSMIds = SieveDown(graph),
 	};
-	auto h = SieveUp(graph);
-	solution.CSMIds.insert(solution.CSMIds.begin(), h.begin(), h.end());
+	auto sievedUp = SieveUp(topology, graph);
+	solution.CSMIds.insert(solution.CSMIds.end(), sievedUp.begin(), sievedUp.end());
 
+	// the sieve removes CSMs that nothing else depends on first
 	std::ranges::reverse(solution.CSMIds);
 
 	return solution;
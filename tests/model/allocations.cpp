@@ -0,0 +1,38 @@
+#include "allocations.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local size_t allocations = 0;
+
+}  // namespace
+
+void *operator new(size_t size) {
+	++allocations;
+	if (void *pointer = std::malloc(size == 0 ? 1 : size)) {
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+	std::free(pointer);
+}
+
+namespace NPropertyModels::NTesting {
+
+TAllocationCounter::TAllocationCounter()
+    : Begin_(allocations) {
+}
+
+size_t TAllocationCounter::GetCount() const {
+	return allocations - Begin_;
+}
+
+}  // namespace NPropertyModels::NTesting
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+namespace NPropertyModels::NTesting {
+
+// Counts the heap allocations made by the current thread since it was
+// created. The test binary replaces the global operator new for this.
+class TAllocationCounter {
+public:
+	TAllocationCounter();
+	TAllocationCounter(const TAllocationCounter &) = delete;
+	TAllocationCounter(TAllocationCounter &&) = delete;
+	TAllocationCounter &operator=(const TAllocationCounter &) = delete;
+	TAllocationCounter &operator=(TAllocationCounter &&) = delete;
+	~TAllocationCounter() = default;
+
+	[[nodiscard]] size_t GetCount() const;
+
+private:
+	size_t Begin_;
+};
+
+}  // namespace NPropertyModels::NTesting
@@ -0,0 +1,120 @@
+#include "property_models/model_table.h"
+
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+namespace NPropertyModels::NTesting {
+
+namespace {
+
+size_t sumRuns = 0;
+
+PM_PROPERTY_MODEL(TRowModel) {
+public:
+	PM_PROPERTY(int, A, 0);
+	PM_PROPERTY(int, B, 1);
+	PM_PROPERTY(int, C, 0);
+
+public:
+	PM_CONSTRAINT(
+	    Sum,
+	    PM_CSM(
+	        PM_IN(A, B),
+	        PM_OUT(C),
+	        ++sumRuns;
+	        C = A + B;
+	    ),
+	    PM_CSM(
+	        PM_IN(A, C),
+	        PM_OUT(B),
+	        B = C - A;
+	    ),
+	);
+};
+
+TEST_CASE("model table executes one plan on every row", "[model_table]") {
+	TModelTable<TRowModel> table(4);
+	REQUIRE(table.Size() == 4);
+	for (size_t row = 0; row < table.Size(); ++row) {
+		CHECK(table.Get(row, &TRowModel::C) == 1);
+	}
+
+	table.SetColumn(&TRowModel::A, std::vector<int>{1, 2, 3, 4});
+	CHECK(table.GetColumn(&TRowModel::C) == std::vector<int>{2, 3, 4, 5});
+	CHECK(table.GetGroupsCount() == 1);
+
+	SECTION("single row edits only run that row") {
+		sumRuns = 0;
+		table.Set(2, &TRowModel::A, 10);
+		CHECK(sumRuns == 1);
+		CHECK(table.Get(2, &TRowModel::C) == 11);
+		CHECK(table.Get(1, &TRowModel::C) == 3);
+	}
+
+	SECTION("equal values are not edits") {
+		sumRuns = 0;
+		table.Set(2, &TRowModel::A, 3);
+		table.SetColumn(&TRowModel::A, std::vector<int>{1, 2, 3, 4});
+		CHECK(sumRuns == 0);
+
+		table.SetColumn(&TRowModel::A, std::vector<int>{1, 2, 3, 5});
+		CHECK(sumRuns == 1);
+		CHECK(table.Get(3, &TRowModel::C) == 6);
+	}
+
+	SECTION("rows are grouped by edit pattern") {
+		table.Set(0, &TRowModel::C, 10);
+		CHECK(table.GetGroupsCount() == 2);
+		CHECK(table.Get(0, &TRowModel::B) == 9);
+		CHECK(table.Get(1, &TRowModel::B) == 1);
+
+		// the edit of row 0 does not change how the other rows are solved
+		table.SetColumn(&TRowModel::A, std::vector<int>{0, 0, 0, 0});
+		CHECK(table.GetColumn(&TRowModel::B) == std::vector<int>{10, 1, 1, 1});
+		CHECK(table.GetColumn(&TRowModel::C) == std::vector<int>{10, 1, 1, 1});
+		CHECK(table.GetGroupsCount() == 2);
+
+		// rows that were edited in the same order share a group again
+		table.Set(1, &TRowModel::C, 5);
+		table.Set(1, &TRowModel::A, 1);
+		CHECK(table.GetGroupsCount() == 2);
+		CHECK(table.Get(1, &TRowModel::B) == 4);
+
+		table.SetColumn(&TRowModel::B, std::vector<int>{2, 2, 2, 2});
+		CHECK(table.GetGroupsCount() == 1);
+		CHECK(table.GetColumn(&TRowModel::C) == std::vector<int>{2, 3, 2, 2});
+	}
+
+	SECTION("constraint flags are shared by all rows") {
+		table.Set(0, &TRowModel::C, 10);
+		CHECK(table.GetConstraint(0, &TRowModel::Sum).IsFulfilled());
+		CHECK(table.GetConstraint(1, &TRowModel::Sum).IsFulfilled());
+		table.Disable(&TRowModel::Sum);
+		CHECK_FALSE(table.GetConstraint(0, &TRowModel::Sum).IsEnabled());
+		CHECK_FALSE(table.GetConstraint(1, &TRowModel::Sum).IsFulfilled());
+
+		table.Set(3, &TRowModel::A, 0);
+		CHECK(table.Get(3, &TRowModel::C) == 5);
+
+		table.Enable(&TRowModel::Sum);
+		CHECK(table.Get(3, &TRowModel::C) == 1);
+		CHECK(table.GetConstraint(3, &TRowModel::Sum).IsFulfilled());
+
+		table.SetImportance(&TRowModel::Sum, 3);
+		CHECK(table.GetConstraint(0, &TRowModel::Sum).GetImportance() == 3);
+		CHECK(table.GetConstraint(3, &TRowModel::Sum).GetImportance() == 3);
+
+		// new groups take over the flags
+		table.Disable(&TRowModel::Sum);
+		table.Set(2, &TRowModel::B, 7);
+		CHECK(table.GetGroupsCount() == 3);
+		CHECK_FALSE(table.GetConstraint(2, &TRowModel::Sum).IsEnabled());
+		CHECK(table.GetConstraint(2, &TRowModel::Sum).GetImportance() == 3);
+		CHECK(table.Get(2, &TRowModel::C) == 4);
+	}
+}
+
+}  // namespace
+
+}  // namespace NPropertyModels::NTesting
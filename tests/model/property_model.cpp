@@ -0,0 +1,997 @@
+#include "property_models/model.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "allocations.h"
+#include "catch2/catch_test_macros.hpp"
+
+namespace NPropertyModels::NTesting {
+
+namespace {
+
+PM_PROPERTY_MODEL(TSumModel) {
+public:
+	PM_PROPERTY(int, A, 0);
+	PM_PROPERTY(int, B, 0);
+	PM_PROPERTY(int, C, 0);
+
+public:
+	PM_CONSTRAINT(
+	    Sum,
+	    PM_IMPORTANCE(0),
+	    PM_CSM(
+	        PM_IN(A, B),
+	        PM_OUT(C),
+	        C = A + B;
+	    ),
+	    PM_CSM(
+	        PM_IN(A, C),
+	        PM_OUT(B),
+	        B = C - A;
+	    ),
+	    PM_CSM(
+	        PM_IN(B, C),
+	        PM_OUT(A),
+	        A = C - B;
+	    ),
+	);
+	PM_CONSTRAINT(
+	    Difference,
+	    PM_IMPORTANCE(1),
+	    PM_CSM(
+	        PM_IN(A, B),
+	        PM_OUT(C),
+	        C = A - B;
+	    ),
+	    PM_CSM(
+	        PM_IN(A, C),
+	        PM_OUT(B),
+	        B = A - C;
+	    ),
+	    PM_CSM(
+	        PM_IN(B, C),
+	        PM_OUT(A),
+	        A = C + B;
+	    ),
+	);
+};
+
+PM_PROPERTY_MODEL(TThrowingModel) {
+public:
+	PM_PROPERTY(int, X, 0);
+	PM_PROPERTY(int, Y, 0);
+
+public:
+	PM_CONSTRAINT(
+	    Copy,
+	    PM_CSM(
+	        PM_IN(X),
+	        PM_OUT(Y),
+	        if (X < 0) {
+		        throw std::invalid_argument("negative");
+	        }
+	        Y = X;
+	    ),
+	);
+};
+
+size_t doubleRuns = 0;
+size_t incrementRuns = 0;
+
+PM_PROPERTY_MODEL(TChainsModel) {
+public:
+	PM_PROPERTY(int, X, 0);
+	PM_PROPERTY(int, Y, 0);
+	PM_PROPERTY(int, P, 0);
+	PM_PROPERTY(int, Q, 0);
+
+public:
+	PM_CONSTRAINT(
+	    Double,
+	    PM_CSM(
+	        PM_IN(X),
+	        PM_OUT(Y),
+	        ++doubleRuns;
+	        Y = X * 2;
+	    ),
+	    PM_CSM(
+	        PM_IN(Y),
+	        PM_OUT(X),
+	        ++doubleRuns;
+	        X = Y / 2;
+	    ),
+	);
+	PM_CONSTRAINT(
+	    Increment,
+	    PM_CSM(
+	        PM_IN(P),
+	        PM_OUT(Q),
+	        ++incrementRuns;
+	        Q = P + 1;
+	    ),
+	    PM_CSM(
+	        PM_IN(Q),
+	        PM_OUT(P),
+	        ++incrementRuns;
+	        P = Q - 1;
+	    ),
+	);
+};
+
+size_t shiftRuns = 0;
+
+PM_PROPERTY_MODEL(TClampModel) {
+public:
+	PM_PROPERTY(int, Value, 0);
+	PM_PROPERTY(int, Clamped, 0);
+	PM_PROPERTY(int, Shifted, 0);
+
+public:
+	PM_CONSTRAINT(
+	    Clamp,
+	    PM_CSM(
+	        PM_IN(Value),
+	        PM_OUT(Clamped),
+	        Clamped = std::min<int>(Value, 10);
+	    ),
+	);
+	PM_CONSTRAINT(
+	    Shift,
+	    PM_CSM(
+	        PM_IN(Clamped),
+	        PM_OUT(Shifted),
+	        ++shiftRuns;
+	        Shifted = Clamped + 1;
+	    ),
+	);
+};
+
+PM_PROPERTY_MODEL(TFanModel) {
+public:
+	PM_PROPERTY(int, Source, 0);
+	PM_PROPERTY(int, B1, 0);
+	PM_PROPERTY(int, B2, 0);
+	PM_PROPERTY(int, B3, 0);
+	PM_PROPERTY(int, B4, 0);
+	PM_PROPERTY(int, Total, 0);
+
+public:
+	PM_CONSTRAINT(Add1, PM_CSM(PM_IN(Source), PM_OUT(B1), B1 = Source + 1;), );
+	PM_CONSTRAINT(Add2, PM_CSM(PM_IN(Source), PM_OUT(B2), B2 = Source + 2;), );
+	PM_CONSTRAINT(Add3, PM_CSM(PM_IN(Source), PM_OUT(B3), B3 = Source + 3;), );
+	PM_CONSTRAINT(Add4, PM_CSM(PM_IN(Source), PM_OUT(B4), B4 = Source + 4;), );
+	PM_CONSTRAINT(
+	    Sum,
+	    PM_CSM(
+	        PM_IN(B1, B2, B3, B4),
+	        PM_OUT(Total),
+	        Total = B1 + B2 + B3 + B4;
+	    ),
+	);
+};
+
+PM_PROPERTY_MODEL(TTextModel) {
+public:
+	PM_PROPERTY(std::string, First);
+	PM_PROPERTY(std::string, Last);
+	PM_PROPERTY(std::string, Full);
+
+public:
+	PM_CONSTRAINT(
+	    Join,
+	    PM_CSM(
+	        PM_IN(First, Last),
+	        PM_OUT(Full),
+	        Full = First.Get() + " " + Last.Get();
+	    ),
+	);
+};
+
+TEST_CASE("property model reuses plan for repeated edits", "[model][plan]") {
+	TSumModel model;
+
+	model.A = 1;
+	model.B = 2;
+	CHECK(model.C.Get() == 3);
+
+	SECTION("same property edited again") {
+		model.B = 5;
+		CHECK(model.C.Get() == 6);
+		model.B = 7;
+		CHECK(model.C.Get() == 8);
+		CHECK(model.A.Get() == 1);
+	}
+
+	SECTION("stay order changes") {
+		model.C = 10;
+		CHECK(model.A.Get() == 8);
+		CHECK(model.B.Get() == 2);
+		model.C = 12;
+		CHECK(model.A.Get() == 10);
+	}
+
+	SECTION("constraint changes") {
+		CHECK(model.Sum.IsFulfilled());
+		CHECK_FALSE(model.Difference.IsFulfilled());
+
+		model.Sum.Disable();
+		CHECK(model.Difference.IsFulfilled());
+		CHECK(model.C.Get() == -1);
+
+		model.B = 3;
+		CHECK(model.C.Get() == -2);
+	}
+}
+
+TEST_CASE("property model batches edits while frozen", "[model][freeze]") {
+	TSumModel model;
+	size_t updates = 0;
+	model.RegisterCallback([&updates]() { ++updates; });
+
+	{
+		auto outer = model.Freeze();
+		model.A = 1;
+		model.B = 2;
+		{
+			auto inner = model.Freeze();
+			model.Difference.SetImportance(2);
+			model.Sum.Disable();
+			model.Sum.Enable();
+			model.B = 4;
+		}
+		CHECK(updates == 0);
+		CHECK(model.C.Get() == 0);
+	}
+
+	CHECK(updates == 1);
+	CHECK(model.C.Get() == 5);
+	CHECK(model.Sum.IsFulfilled());
+
+	model.A = 2;
+	CHECK(updates == 2);
+	CHECK(model.C.Get() == 6);
+}
+
+TEST_CASE("property model does not allocate on plan cache hits", "[model][plan_cache][allocations]") {
+	TSumModel model;
+	// every edit moves another stay to the front, so every update replans
+	for (int i = 0; i < 4; ++i) {
+		model.A = i;
+		model.B = i;
+	}
+	REQUIRE(model.GetPlanCacheStats().Misses == 2);
+
+	size_t allocations = 0;
+	{
+		TAllocationCounter counter;
+		for (int i = 0; i < 30; ++i) {
+			model.A = 10 + i;
+			model.B = 20 + i;
+		}
+		allocations = counter.GetCount();
+	}
+	CHECK(allocations == 0);
+	CHECK(model.C.Get() == 88);
+	CHECK(model.GetPlanCacheStats().Hits == 64);
+}
+
+TEST_CASE("property model caches plans by edit pattern", "[model][plan_cache]") {
+	TSumModel model;
+
+	model.A = 1;
+	model.B = 2;
+	auto stats = model.GetPlanCacheStats();
+	CHECK(stats.Hits == 0);
+	CHECK(stats.Misses == 2);
+
+	model.A = 3;
+	model.B = 4;
+	CHECK(model.C.Get() == 7);
+	stats = model.GetPlanCacheStats();
+	CHECK(stats.Hits == 2);
+	CHECK(stats.Misses == 2);
+	CHECK(stats.Size == 2);
+
+	SECTION("eviction") {
+		model.SetPlanCacheCapacity(1);
+		CHECK(model.GetPlanCacheStats().Size == 1);
+
+		model.A = 5;
+		model.B = 6;
+		CHECK(model.C.Get() == 11);
+		stats = model.GetPlanCacheStats();
+		CHECK(stats.Hits == 2);
+		CHECK(stats.Misses == 4);
+	}
+
+	SECTION("disabled cache") {
+		model.SetPlanCacheCapacity(0);
+		model.A = 5;
+		model.B = 6;
+		CHECK(model.C.Get() == 11);
+		CHECK(model.GetPlanCacheStats().Size == 0);
+	}
+}
+
+TEST_CASE("property model executes only CSMs downstream of edits", "[model][dirty]") {
+	TChainsModel model;
+	model.X = 1;
+	CHECK(model.Y.Get() == 2);
+	CHECK(model.Q.Get() == 1);
+
+	doubleRuns = 0;
+	incrementRuns = 0;
+
+	model.X = 2;
+	CHECK(model.Y.Get() == 4);
+	CHECK(doubleRuns == 1);
+	CHECK(incrementRuns == 0);
+
+	model.X = 3;
+	CHECK(model.Y.Get() == 6);
+	CHECK(doubleRuns == 2);
+	CHECK(incrementRuns == 0);
+
+	{
+		auto _ = model.Freeze();
+		model.P = 4;
+		model.X = 5;
+	}
+	CHECK(model.Y.Get() == 10);
+	CHECK(model.Q.Get() == 5);
+	CHECK(doubleRuns == 3);
+	CHECK(incrementRuns == 1);
+}
+
+TEST_CASE("property model evaluates lazily on read", "[model][lazy]") {
+	SECTION("reads pull the minimal chain") {
+		TChainsModel model;
+		model.SetLazyEvaluation(true);
+		doubleRuns = 0;
+		incrementRuns = 0;
+
+		model.X = 5;
+		CHECK(doubleRuns == 0);
+		CHECK(incrementRuns == 0);
+
+		CHECK(model.Y.Get() == 10);
+		CHECK(model.Y.Get() == 10);
+		CHECK(doubleRuns == 1);
+		CHECK(incrementRuns == 0);
+
+		model.X = 6;
+		model.X = 7;
+		CHECK(doubleRuns == 1);
+		CHECK(static_cast<const int &>(model.Y) == 14);
+		CHECK(doubleRuns == 2);
+
+		model.SetLazyEvaluation(false);
+		CHECK(incrementRuns == 1);
+		CHECK(model.Q.Get() == 1);
+	}
+
+	SECTION("writes see scheduled values") {
+		TSumModel model;
+		model.SetLazyEvaluation(true);
+
+		model.A = 1;
+		model.B = 2;
+		model.C = 10;
+		CHECK(model.A.Get() == 8);
+		CHECK(model.B.Get() == 2);
+		CHECK(model.C.Get() == 10);
+	}
+}
+
+TEST_CASE("property model uses precomputed plans", "[model][precomputed]") {
+	TSumModel model;
+	model.SetPrecomputedPlans(true);
+
+	model.A = 1;
+	model.B = 2;
+	CHECK(model.C.Get() == 3);
+	CHECK(model.Sum.IsFulfilled());
+	CHECK_FALSE(model.Difference.IsFulfilled());
+	CHECK(model.GetPlanCacheStats().Misses == 0);
+
+	// the stays of A and B are not in declaration order, the order is
+	// solved once and added to the plans, B is kept
+	model.C = 10;
+	CHECK(model.A.Get() == 8);
+	CHECK(model.B.Get() == 2);
+	CHECK(model.GetPlanCacheStats().Misses == 0);
+
+	// other instances find the order in the plans of the model type
+	TSumModel other;
+	other.SetPrecomputedPlans(true);
+	other.B = 2;
+	other.C = 10;
+	CHECK(other.A.Get() == 8);
+	CHECK(other.GetPlanCacheStats().Misses == 0);
+
+	// the flags differ from those the plans were built with
+	model.Sum.Disable();
+	CHECK(model.Difference.IsFulfilled());
+	CHECK(model.GetPlanCacheStats().Misses == 1);
+
+	model.Sum.Enable();
+	model.A = 2;
+	CHECK(model.A.Get() == 2);
+	CHECK(model.C.Get() == model.A.Get() + model.B.Get());
+	CHECK(model.GetPlanCacheStats().Misses == 1);
+
+	model.B = 3;
+	model.A = 1;
+	CHECK(model.C.Get() == 4);
+	CHECK(model.GetPlanCacheStats().Misses == 1);
+}
+
+TEST_CASE("property model gets the solver's values from precomputed plans", "[model][precomputed]") {
+	TSumModel precomputed;
+	precomputed.SetPrecomputedPlans(true);
+	TSumModel solved;
+
+	// edits in every order, so that the stays after the edited property
+	// are in declaration order only some of the time
+	const std::vector<std::pair<char, int>> edits{
+	    {'A', 1}, {'B', 2}, {'C', 10}, {'B', 1}, {'A', 4}, {'C', -3}, {'A', 0}, {'B', 5}, {'C', 2}, {'C', 9}, {'A', 3},
+	};
+	for (const auto &[name, value] : edits) {
+		for (TSumModel *model : {&precomputed, &solved}) {
+			switch (name) {
+				case 'A':
+					model->A = value;
+					break;
+				case 'B':
+					model->B = value;
+					break;
+				default:
+					model->C = value;
+					break;
+			}
+		}
+		CHECK(precomputed.A.Get() == solved.A.Get());
+		CHECK(precomputed.B.Get() == solved.B.Get());
+		CHECK(precomputed.C.Get() == solved.C.Get());
+	}
+}
+
+TEST_CASE("property model replans only when constraint order changes", "[model][importance]") {
+	TSumModel model;
+	model.A = 1;
+	model.B = 2;
+
+	size_t updates = 0;
+	model.RegisterCallback([&updates]() { ++updates; });
+
+	model.Difference.SetImportance(5);
+	model.Difference.SetImportance(0);
+	CHECK(updates == 0);
+	CHECK(model.Sum.IsFulfilled());
+
+	model.Sum.SetImportance(10);
+	CHECK(updates == 1);
+	CHECK(model.Difference.IsFulfilled());
+	CHECK_FALSE(model.Sum.IsFulfilled());
+	CHECK(model.C.Get() == -1);
+
+	model.Sum.Disable();
+	model.Sum.SetImportance(0);
+	CHECK(updates == 2);
+	CHECK(model.Difference.IsFulfilled());
+}
+
+TEST_CASE("property model stops propagation at unchanged values", "[model][cutoff]") {
+	SECTION("no-op writes") {
+		TChainsModel model;
+		model.X = 3;
+		doubleRuns = 0;
+
+		size_t updates = 0;
+		model.RegisterCallback([&updates]() { ++updates; });
+
+		model.X = 3;
+		model.X.Set(3);
+		CHECK(updates == 0);
+		CHECK(doubleRuns == 0);
+		CHECK(model.Y.Get() == 6);
+	}
+
+	SECTION("unchanged CSM outputs") {
+		TClampModel model;
+		model.Value = 20;
+		CHECK(model.Shifted.Get() == 11);
+		shiftRuns = 0;
+
+		model.Value = 30;
+		CHECK(model.Clamped.Get() == 10);
+		CHECK(shiftRuns == 0);
+
+		model.Value = 5;
+		CHECK(model.Shifted.Get() == 6);
+		CHECK(shiftRuns == 1);
+	}
+}
+
+TEST_CASE("property model delivers changes once per update", "[model][subscriptions]") {
+	SECTION("properties") {
+		TClampModel model;
+
+		size_t shiftedCalls = 0;
+		model.Shifted.RegisterCallback([&shiftedCalls]() { ++shiftedCalls; });
+		std::vector<std::vector<size_t>> changes;
+		model.RegisterChangesCallback([&changes](const TChangeSet &changeSet) {
+			changes.push_back(changeSet.PropertyIds);
+			std::ranges::sort(changes.back());
+		});
+
+		model.Value = 20;
+		CHECK(shiftedCalls == 1);
+		REQUIRE(changes.size() == 1);
+		CHECK(changes[0] == std::vector<size_t>{model.Value.GetId(), model.Clamped.GetId(), model.Shifted.GetId()});
+
+		model.Value = 30;
+		CHECK(shiftedCalls == 1);
+		REQUIRE(changes.size() == 2);
+		CHECK(changes[1] == std::vector<size_t>{model.Value.GetId()});
+
+		model.Shifted.UnregisterCallback();
+		model.Value = 0;
+		CHECK(shiftedCalls == 1);
+	}
+
+	SECTION("constraints") {
+		TSumModel model;
+		model.A = 1;
+
+		size_t sumCalls = 0;
+		size_t differenceCalls = 0;
+		model.Sum.RegisterCallback([&sumCalls]() { ++sumCalls; });
+		model.Difference.RegisterCallback([&differenceCalls]() { ++differenceCalls; });
+
+		model.B = 2;
+		CHECK(sumCalls == 0);
+		CHECK(differenceCalls == 0);
+
+		model.Sum.Disable();
+		CHECK(sumCalls == 1);
+		CHECK(differenceCalls == 1);
+		CHECK(model.Difference.IsFulfilled());
+	}
+}
+
+TEST_CASE("property model plans in background", "[model][async]") {
+	TChainsModel model;
+	model.SetAsyncPlanning(true);
+	REQUIRE(model.IsAsyncPlanning());
+
+	// nothing to fall back to yet
+	model.X = 1;
+	CHECK_FALSE(model.IsPlanPending());
+	CHECK(model.Y.Get() == 2);
+
+	SECTION("previous plan keeps running") {
+		model.P = 5;
+		CHECK(model.Q.Get() == 6);
+		model.AwaitPlan();
+		CHECK_FALSE(model.IsPlanPending());
+		CHECK(model.GetPlanCacheStats().Size == 2);
+
+		model.P = 7;
+		CHECK_FALSE(model.IsPlanPending());
+		CHECK(model.Q.Get() == 8);
+	}
+
+	SECTION("edits written by previous plan wait") {
+		model.Q = 10;
+		CHECK_FALSE(model.IsPlanPending());
+		CHECK(model.P.Get() == 9);
+	}
+
+	SECTION("disabling") {
+		model.SetAsyncPlanning(false);
+		model.P = 5;
+		CHECK_FALSE(model.IsPlanPending());
+		CHECK(model.Q.Get() == 6);
+	}
+}
+
+TEST_CASE("property model executes independent CSMs in parallel", "[model][parallel]") {
+	TFanModel model;
+	model.SetParallelExecution(4, 2);
+
+	for (int i = 1; i <= 100; ++i) {
+		model.Source = i;
+		CHECK(model.Total.Get() == 4 * i + 10);
+	}
+
+	TExecutionStats stats = model.GetExecutionStats();
+	CHECK(stats.ExecutedCSMs == 500);
+	CHECK(stats.Levels == 200);
+	CHECK(stats.ParallelLevels == 100);
+	CHECK(stats.ParallelCSMs == 400);
+
+	SECTION("below threshold") {
+		model.SetParallelExecution(4, 5);
+		model.Source = -1;
+		CHECK(model.Total.Get() == 6);
+		CHECK(model.GetExecutionStats().ParallelLevels == 100);
+	}
+
+	SECTION("only affected CSMs") {
+		model.SetParallelExecution(1);
+		// derived values are restored by their producers
+		model.B1 = 0;
+		CHECK(model.B1.Get() == 101);
+		CHECK(model.Total.Get() == 410);
+		CHECK(model.GetExecutionStats().ExecutedCSMs == 502);
+	}
+}
+
+TEST_CASE("property model gives readers consistent snapshots", "[model][snapshot]") {
+	TSumModel model;
+	model.A = 1;
+
+	SECTION("versions") {
+		uint64_t version = model.GetVersion();
+		CHECK(version % 2 == 0);
+
+		{
+			auto guard = model.Freeze();
+			model.B = 2;
+			CHECK(model.GetVersion() % 2 == 1);
+		}
+		CHECK(model.GetVersion() % 2 == 0);
+		CHECK(model.GetVersion() > version);
+
+		model.SetLazyEvaluation(true);
+		CHECK_THROWS(model.ReadSnapshot([](const auto &) { return 0; }));
+	}
+
+	SECTION("readers give up while the writer is busy") {
+		auto guard = model.Freeze();
+		model.B = 2;
+		CHECK_FALSE(model.ReadSnapshot([&](const auto &snapshot) { return snapshot.Get(model.C); }, 10).has_value());
+	}
+
+	SECTION("throwing CSM ends the write") {
+		TThrowingModel throwing;
+		CHECK_THROWS(throwing.X = -1);
+		CHECK(throwing.GetVersion() % 2 == 0);
+		CHECK(throwing.ReadSnapshot([&](const auto &snapshot) { return snapshot.Get(throwing.X); }) == -1);
+
+		throwing.X = 2;
+		CHECK(throwing.Y.Get() == 2);
+	}
+
+	SECTION("constraint edits are writes") {
+		model.Sum.Disable();
+		CHECK(model.GetVersion() % 2 == 0);
+		auto fulfilled = model.ReadSnapshot([&](const auto &snapshot) {
+			return std::pair{snapshot.IsFulfilled(model.Sum), snapshot.IsFulfilled(model.Difference)};
+		});
+		CHECK(fulfilled == std::pair{false, true});
+
+		// does not change the order of constraints, so nothing updates
+		uint64_t version = model.GetVersion();
+		model.Difference.SetImportance(5);
+		CHECK(model.GetVersion() % 2 == 0);
+		CHECK(model.GetVersion() > version);
+	}
+
+	SECTION("concurrent writer") {
+		std::atomic<bool> done = false;
+		std::atomic<size_t> inconsistent = 0;
+		std::vector<std::thread> readers;
+		for (size_t i = 0; i < 2; ++i) {
+			readers.emplace_back([&model, &done, &inconsistent]() {
+				while (!done.load()) {
+					auto snapshot = model.ReadSnapshot([&model](const auto &snapshot) {
+						return std::tuple{
+						    snapshot.Get(model.A),
+						    snapshot.Get(model.B),
+						    snapshot.Get(model.C),
+						    snapshot.IsFulfilled(model.Sum),
+						};
+					});
+					if (!snapshot) {
+						continue;
+					}
+					auto [a, b, c, sum] = *snapshot;
+					if (c != (sum ? a + b : a - b)) {
+						++inconsistent;
+					}
+				}
+			});
+		}
+
+		for (int i = 0; i < 20000; ++i) {
+			if (i % 100 == 50) {
+				model.Sum.Disable();
+			} else if (i % 100 == 0) {
+				model.Sum.Enable();
+			}
+			if (i % 2 == 0) {
+				model.A = i;
+			} else {
+				model.B = -i;
+			}
+		}
+		done = true;
+		for (auto &reader : readers) {
+			reader.join();
+		}
+		CHECK(inconsistent == 0);
+	}
+}
+
+TEST_CASE("property model attaches and detaches constraints at runtime", "[model][structure]") {
+	TSumModel model;
+	model.A = 1;
+	model.B = 2;
+
+	auto doubled = std::make_unique<TProperty<int, TSumModel>>(model, 0);
+	TProperty<int, TSumModel> &d = *doubled;
+	auto constraint = std::make_unique<TConstraint<TSumModel>>(
+	    model,
+	    0,
+	    std::vector{
+	        TCSM<TSumModel>::Make({model.C.GetId()}, {d.GetId()}, [&](TSumModel &m) { d = m.C * 2; }),
+	        TCSM<TSumModel>::Make({d.GetId()}, {model.C.GetId()}, [&](TSumModel &m) { m.C = d / 2; }),
+	    }
+	);
+	CHECK(model.C.Get() == 3);
+	CHECK(d.Get() == 6);
+	CHECK(constraint->IsFulfilled());
+
+	d = 10;
+	CHECK(model.C.Get() == 5);
+	CHECK(model.A.Get() + model.B.Get() == 5);
+
+	model.A = 4;
+	CHECK(d.Get() == 2 * model.C.Get());
+
+	constraint.reset();
+	model.A = 7;
+	CHECK(model.C.Get() == 7 + model.B.Get());
+	CHECK(d.Get() != 2 * model.C.Get());
+
+	doubled.reset();
+	model.B = 1;
+	CHECK(model.C.Get() == 8);
+	CHECK(model.Sum.IsFulfilled());
+}
+
+TEST_CASE("property model applies constraints attached while frozen on unfreeze", "[model][structure]") {
+	TSumModel model;
+	model.A = 1;
+	model.B = 2;
+
+	TProperty<int, TSumModel> d(model, 0);
+	std::optional<TConstraint<TSumModel>> constraint;
+	{
+		auto guard = model.Freeze();
+		constraint.emplace(
+		    model,
+		    0,
+		    std::vector{
+		        TCSM<TSumModel>::Make({model.C.GetId()}, {d.GetId()}, [&](TSumModel &m) { d = m.C * 2; }),
+		    }
+		);
+		CHECK(d.Get() == 0);
+	}
+	CHECK(d.Get() == 6);
+	CHECK(constraint->IsFulfilled());
+}
+
+TEST_CASE("property model rolls back speculative edits", "[model][speculation]") {
+	TSumModel model;
+	model.A = 1;
+	model.B = 2;
+	size_t callbacks = 0;
+	model.RegisterCallback([&callbacks]() { ++callbacks; });
+
+	SECTION("values and stay order") {
+		{
+			auto guard = model.Speculate();
+			CHECK(model.IsSpeculating());
+			model.C = 10;
+			CHECK(model.A.Get() == 8);
+			CHECK(model.B.Get() == 2);
+		}
+		CHECK_FALSE(model.IsSpeculating());
+		CHECK(model.A.Get() == 1);
+		CHECK(model.B.Get() == 2);
+		CHECK(model.C.Get() == 3);
+		CHECK(callbacks == 0);
+
+		// B is still the strongest stay
+		model.C = 5;
+		CHECK(model.B.Get() == 2);
+		CHECK(model.A.Get() == 3);
+		CHECK(callbacks == 1);
+	}
+
+	SECTION("nested") {
+		auto outer = model.Speculate();
+		model.A = 5;
+		{
+			auto inner = model.Speculate();
+			model.A = 7;
+			model.Sum.Disable();
+			model.B = 1;
+			CHECK(model.C.Get() == 6);
+		}
+		CHECK(model.Sum.IsEnabled());
+		CHECK(model.A.Get() == 5);
+		CHECK(model.B.Get() == 2);
+		CHECK(model.C.Get() == 7);
+	}
+
+	SECTION("frozen") {
+		auto guard = model.Freeze();
+		CHECK_THROWS(model.Speculate());
+	}
+}
+
+TEST_CASE("property model undoes and redoes updates", "[model][history]") {
+	TSumModel model;
+	model.SetHistoryCapacity(2);
+	model.A = 1;
+	model.B = 2;
+	CHECK(model.GetUndoCount() == 2);
+
+	std::vector<size_t> changed;
+	model.RegisterChangesCallback([&changed](const TChangeSet &changes) { changed = changes.PropertyIds; });
+
+	// the oldest update is dropped
+	model.C = 10;
+	CHECK(model.A.Get() == 8);
+	CHECK(model.GetUndoCount() == 2);
+
+	CHECK(model.Undo());
+	CHECK(model.A.Get() == 1);
+	CHECK(model.B.Get() == 2);
+	CHECK(model.C.Get() == 3);
+	std::ranges::sort(changed);
+	CHECK(changed == std::vector<size_t>{model.A.GetId(), model.C.GetId()});
+
+	CHECK(model.Undo());
+	CHECK(model.B.Get() == 0);
+	CHECK(model.C.Get() == 1);
+	CHECK_FALSE(model.Undo());
+	CHECK(model.GetRedoCount() == 2);
+
+	CHECK(model.Redo());
+	CHECK(model.Redo());
+	CHECK_FALSE(model.Redo());
+	CHECK(model.A.Get() == 8);
+	CHECK(model.C.Get() == 10);
+
+	// the stay order is restored too, B is the strongest stay again
+	CHECK(model.Undo());
+	model.C = 4;
+	CHECK(model.A.Get() == 2);
+	CHECK(model.B.Get() == 2);
+	CHECK(model.GetRedoCount() == 0);
+
+	model.Sum.Disable();
+	CHECK(model.A.Get() == 6);
+	CHECK(model.Undo());
+	CHECK(model.Sum.IsEnabled());
+	CHECK(model.Sum.IsFulfilled());
+	CHECK(model.A.Get() == 2);
+}
+
+TEST_CASE("property model records history without allocating", "[model][history][allocations]") {
+	TSumModel model;
+	model.SetHistoryCapacity(4);
+	// every slot of the ring has been used and grown once
+	for (int i = 1; i <= 10; ++i) {
+		model.A = i;
+		model.C = 2 * i;
+	}
+
+	size_t allocations = 0;
+	{
+		TAllocationCounter counter;
+		for (int i = 11; i <= 30; ++i) {
+			model.A = i;
+			model.C = 2 * i;
+		}
+		CHECK(model.Undo());
+		CHECK(model.Redo());
+		allocations = counter.GetCount();
+	}
+	CHECK(allocations == 0);
+	CHECK(model.GetUndoCount() == 4);
+	CHECK(model.Undo());
+	CHECK(model.A.Get() == 30);
+	CHECK(model.B.Get() == 28);
+	CHECK(model.C.Get() == 58);
+}
+
+TEST_CASE("property model undoes values that own memory", "[model][history]") {
+	TTextModel model;
+	model.SetHistoryCapacity(3);
+	model.First = std::string(100, 'a');
+	model.Last = "b";
+	CHECK(model.Full.Get() == std::string(100, 'a') + " b");
+
+	CHECK(model.Undo());
+	CHECK(model.Full.Get() == std::string(100, 'a') + " ");
+	CHECK(model.Undo());
+	CHECK(model.First.Get().empty());
+	CHECK(model.Full.Get().empty());
+
+	CHECK(model.Redo());
+	CHECK(model.Redo());
+	CHECK(model.Full.Get() == std::string(100, 'a') + " b");
+
+	{
+		auto guard = model.Speculate();
+		model.Last = std::string(200, 'c');
+		CHECK(model.Full.Get().size() == 301);
+	}
+	CHECK(model.Last.Get() == "b");
+	CHECK(model.Full.Get() == std::string(100, 'a') + " b");
+}
+
+TEST_CASE("property model records history with parallel execution", "[model][history][parallel]") {
+	TFanModel model;
+	model.SetParallelExecution(4, 2);
+	model.SetHistoryCapacity(100);
+
+	// the history is not shared between threads, so levels run inline
+	for (int i = 1; i <= 50; ++i) {
+		model.Source = i;
+	}
+	CHECK(model.Total.Get() == 4 * 50 + 10);
+	CHECK(model.GetExecutionStats().ParallelLevels == 0);
+
+	for (int i = 49; i >= 1; --i) {
+		CHECK(model.Undo());
+		CHECK(model.B4.Get() == i + 4);
+		CHECK(model.Total.Get() == 4 * i + 10);
+	}
+
+	model.SetHistoryCapacity(0);
+	model.Source = 100;
+	CHECK(model.Total.Get() == 410);
+	CHECK(model.GetExecutionStats().ParallelLevels == 1);
+}
+
+TEST_CASE("property model keeps importance changes out of the next undo step", "[model][history]") {
+	TSumModel model;
+	model.SetHistoryCapacity(2);
+	model.A = 1;
+
+	// the constraint order stays the same, so there is no update to undo
+	model.Difference.SetImportance(5);
+	CHECK(model.GetUndoCount() == 1);
+
+	model.B = 2;
+	CHECK(model.GetUndoCount() == 2);
+	CHECK(model.Undo());
+	CHECK(model.B.Get() == 0);
+	CHECK(model.Difference.GetImportance() == 5);
+
+	// a reordering change is its own step
+	model.Sum.SetImportance(10);
+	CHECK(model.GetUndoCount() == 2);
+	CHECK(model.Undo());
+	CHECK(model.Sum.GetImportance() == 0);
+	CHECK(model.Sum.IsFulfilled());
+}
+
+}  // namespace
+
+}  // namespace NPropertyModels::NTesting
@@ -0,0 +1,366 @@
+#include "solver/delta_blue.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <ranges>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+#include "catch2/matchers/catch_matchers_vector.hpp"
+
+namespace NPropertyModels::NSolver::NTesting {
+
+namespace {
+
+using namespace Catch::Matchers;
+
+// two-way equalities between neighbours followed by stays of the properties
+// in the given order
+TTask MakeChainTask(size_t length, const std::vector<size_t> &stayOrder) {
+	TTask task{
+	    .PropertiesCount = length + 1,
+	    .ConstraintsCount = length + stayOrder.size(),
+	    .CSMs{},
+	};
+	for (size_t id = 0; id < length; ++id) {
+		task.CSMs.push_back({.ConstraintId = id, .InputPropertyIds = {id}, .OutputPropertyIds = {id + 1}});
+		task.CSMs.push_back({.ConstraintId = id, .InputPropertyIds = {id + 1}, .OutputPropertyIds = {id}});
+	}
+	for (size_t stayId = 0; stayId < stayOrder.size(); ++stayId) {
+		task.CSMs.push_back({.ConstraintId = length + stayId, .InputPropertyIds = {}, .OutputPropertyIds = {stayOrder[stayId]}});
+	}
+	return task;
+}
+
+// every property is written once and after the properties it is computed
+// from, every constraint has at most one CSM in the plan
+bool IsValidPlan(const TTask &task, const TSolution &solution) {
+	std::vector<uint8_t> written(task.PropertiesCount, 0);
+	std::vector<uint8_t> planned(task.ConstraintsCount, 0);
+	for (const auto &csmId : solution.CSMIds) {
+		const auto &csm = task.CSMs[csmId];
+		if (planned[csm.ConstraintId]++ || written[csm.OutputPropertyIds.front()]++) {
+			return false;
+		}
+	}
+	std::vector<uint8_t> ready(task.PropertiesCount, 0);
+	for (const auto &csmId : solution.CSMIds) {
+		const auto &csm = task.CSMs[csmId];
+		for (const auto &propertyId : csm.InputPropertyIds) {
+			if (written[propertyId] && !ready[propertyId]) {
+				return false;
+			}
+		}
+		ready[csm.OutputPropertyIds.front()] = 1;
+	}
+	return std::ranges::all_of(written, [](uint8_t value) { return value == 1; });
+}
+
+// two equalities between the same properties, the stays of the properties
+// follow in the given order
+TTask MakeDoubleEqualityTask(const std::vector<size_t> &stayOrder) {
+	TTask task = MakeChainTask(1, stayOrder);
+	task.CSMs.insert(
+	    task.CSMs.begin() + 2,
+	    {
+	        {.ConstraintId = 1, .InputPropertyIds = {0}, .OutputPropertyIds = {1}},
+	        {.ConstraintId = 1, .InputPropertyIds = {1}, .OutputPropertyIds = {0}},
+	    }
+	);
+	for (auto &csm : task.CSMs | std::views::drop(4)) {
+		++csm.ConstraintId;
+	}
+	++task.ConstraintsCount;
+	return task;
+}
+
+// two three-way sums over the same properties followed by their stays
+TTask MakeDoubleSumTask(const std::vector<size_t> &stayOrder) {
+	TTask task{
+	    .PropertiesCount = 3,
+	    .ConstraintsCount = 2 + stayOrder.size(),
+	    .CSMs{},
+	};
+	for (size_t sumId = 0; sumId < 2; ++sumId) {
+		task.CSMs.push_back({.ConstraintId = sumId, .InputPropertyIds = {0, 1}, .OutputPropertyIds = {2}});
+		task.CSMs.push_back({.ConstraintId = sumId, .InputPropertyIds = {0, 2}, .OutputPropertyIds = {1}});
+		task.CSMs.push_back({.ConstraintId = sumId, .InputPropertyIds = {1, 2}, .OutputPropertyIds = {0}});
+	}
+	for (size_t stayId = 0; stayId < stayOrder.size(); ++stayId) {
+		task.CSMs.push_back({.ConstraintId = 2 + stayId, .InputPropertyIds = {}, .OutputPropertyIds = {stayOrder[stayId]}});
+	}
+	return task;
+}
+
+// a multi-way sum over the given properties
+void AddSum(TTask &task, const std::vector<size_t> &propertyIds) {
+	const size_t sumId = task.ConstraintsCount++;
+	for (const auto &outputId : propertyIds) {
+		TCSM csm{.ConstraintId = sumId, .InputPropertyIds = {}, .OutputPropertyIds = {outputId}};
+		for (const auto &inputId : propertyIds) {
+			if (inputId != outputId) {
+				csm.InputPropertyIds.push_back(inputId);
+			}
+		}
+		task.CSMs.push_back(std::move(csm));
+	}
+}
+
+TEST_CASE("delta blue implemets is applicable right", "[solver][delta_blue][is_applicable]") {
+	TSolver solver{TDeltaBlueSolver{}};
+
+	SECTION("incorrect task") {
+		TTask task = GENERATE(
+		    TTask{
+		        .PropertiesCount = 2,
+		        .ConstraintsCount = 0,
+		        .CSMs{
+		            {
+		                .ConstraintId = 0,
+		                .InputPropertyIds = {0},
+		                .OutputPropertyIds = {1},
+		            },
+		        },
+		    },
+		    TTask{
+		        .PropertiesCount = 1,
+		        .ConstraintsCount = 1,
+		        .CSMs{
+		            {
+		                .ConstraintId = 0,
+		                .InputPropertyIds = {0},
+		                .OutputPropertyIds = {1},
+		            },
+		        },
+		    },
+		    TTask{
+		        .PropertiesCount = 1,
+		        .ConstraintsCount = 1,
+		        .CSMs{
+		            {
+		                .ConstraintId = 0,
+		                .InputPropertyIds = {0},
+		                .OutputPropertyIds = {0},
+		            },
+		        },
+		    }
+		);
+
+		CHECK_THROWS(solver.IsApplicable(task));
+	}
+
+	SECTION("unapplicable task") {
+		TTask task = GENERATE(
+		    TTask{
+		        .PropertiesCount = 3,
+		        .ConstraintsCount = 1,
+		        .CSMs{
+		            {
+		                .ConstraintId = 0,
+		                .InputPropertyIds = {0},
+		                .OutputPropertyIds = {1, 2},
+		            },
+		        },
+		    },
+		    TTask{
+		        .PropertiesCount = 3,
+		        .ConstraintsCount = 1,
+		        .CSMs{
+		            {
+		                .ConstraintId = 0,
+		                .InputPropertyIds = {0},
+		                .OutputPropertyIds = {1},
+		            },
+		            {
+		                .ConstraintId = 0,
+		                .InputPropertyIds = {0},
+		                .OutputPropertyIds = {2},
+		            },
+		        },
+		    },
+		    MakeDoubleEqualityTask({0, 1}),
+		    MakeDoubleSumTask({0, 1, 2})
+		);
+
+		CHECK(solver.IsApplicable(task) == EApplicability::NOT_APPLICABLE);
+		CHECK_FALSE(solver.TrySolve(task).has_value());
+	}
+
+	SECTION("applicable task") {
+		CHECK(solver.IsApplicable(MakeChainTask(3, {0, 1, 2, 3})) == EApplicability::APPLICABLE);
+	}
+}
+
+TEST_CASE("delta blue implemets try solve right", "[solver][delta_blue][try_solve]") {
+	TSolver solver{TDeltaBlueSolver{}};
+
+	SECTION("empty task") {
+		auto solution = solver.TrySolve({.PropertiesCount = 5, .ConstraintsCount = 5, .CSMs{}});
+		REQUIRE(solution.has_value());
+		CHECK(solution->CSMIds.empty());
+	}
+
+	SECTION("chain follows the strongest stay") {
+		// stays of 0 and 3 are CSMs 6 and 7, equalities write forward with
+		// even CSMs and backward with odd ones
+		auto solution = solver.TrySolve(MakeChainTask(3, {0, 3}));
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution->CSMIds, Equals(std::vector<size_t>{6, 0, 2, 4}));
+
+		solution = solver.TrySolve(MakeChainTask(3, {3, 0}));
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution->CSMIds, Equals(std::vector<size_t>{6, 5, 3, 1}));
+	}
+
+	SECTION("constraints are added and removed between tasks") {
+		TTask task = MakeChainTask(2, {0, 2, 1});
+		auto solution = solver.TrySolve(task);
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution->CSMIds, Equals(std::vector<size_t>{4, 0, 2}));
+
+		// the second equality is removed, 2 keeps its own value
+		task.CSMs.erase(task.CSMs.begin() + 2, task.CSMs.begin() + 4);
+		for (auto &csm : task.CSMs) {
+			csm.ConstraintId -= csm.ConstraintId > 1 ? 1 : 0;
+		}
+		--task.ConstraintsCount;
+		solution = solver.TrySolve(task);
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution->CSMIds, UnorderedEquals(std::vector<size_t>{2, 0, 3}));
+
+		// and added again
+		solution = solver.TrySolve(MakeChainTask(2, {0, 2, 1}));
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution->CSMIds, Equals(std::vector<size_t>{4, 0, 2}));
+	}
+
+	SECTION("kept plan gives the same solution as a new one") {
+		std::mt19937 random(42);
+		std::vector<size_t> stayOrder(21);
+		for (size_t id = 0; id < stayOrder.size(); ++id) {
+			stayOrder[id] = id;
+		}
+
+		for (size_t iteration = 0; iteration < 50; ++iteration) {
+			// the edited property becomes the strongest stay
+			size_t edited = random() % stayOrder.size();
+			std::erase(stayOrder, edited);
+			stayOrder.insert(stayOrder.begin(), edited);
+
+			TTask task = MakeChainTask(stayOrder.size() - 1, stayOrder);
+			auto solution = solver.TrySolve(task);
+			REQUIRE(solution.has_value());
+			CHECK(IsValidPlan(task, *solution));
+
+			auto expected = TSolver{TDeltaBlueSolver{}}.TrySolve(task);
+			REQUIRE(expected.has_value());
+			CHECK_THAT(solution->CSMIds, Equals(expected->CSMIds));
+		}
+	}
+
+	SECTION("random tasks") {
+		std::mt19937 random(7);
+		for (size_t iteration = 0; iteration < 200; ++iteration) {
+			// a random tree of multi-way sums, every sum shares one property
+			// with the sums before it, every property has a stay and stays
+			// come in random order
+			const size_t sumsCount = random() % 8;
+			TTask task{.PropertiesCount = 1, .ConstraintsCount = 0, .CSMs{}};
+			for (size_t sumId = 0; sumId < sumsCount; ++sumId) {
+				std::vector<size_t> propertyIds{random() % task.PropertiesCount};
+				for (size_t arity = 2 + random() % 2; propertyIds.size() < arity;) {
+					propertyIds.push_back(task.PropertiesCount++);
+				}
+				std::ranges::shuffle(propertyIds, random);
+				AddSum(task, propertyIds);
+			}
+			std::vector<size_t> stayOrder(task.PropertiesCount);
+			std::iota(stayOrder.begin(), stayOrder.end(), 0);
+			std::ranges::shuffle(stayOrder, random);
+			for (const auto &propertyId : stayOrder) {
+				task.CSMs.push_back({.ConstraintId = task.ConstraintsCount++, .InputPropertyIds = {}, .OutputPropertyIds = {propertyId}});
+			}
+
+			REQUIRE(solver.IsApplicable(task) == EApplicability::APPLICABLE);
+			auto solution = solver.TrySolve(task);
+			REQUIRE(solution.has_value());
+			CHECK(IsValidPlan(task, *solution));
+		}
+	}
+
+	SECTION("cyclic tasks are not solved and do not change the kept plan") {
+		auto solution = solver.TrySolve(MakeChainTask(1, {0, 1}));
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution->CSMIds, Equals(std::vector<size_t>{2, 0}));
+
+		CHECK_FALSE(solver.TrySolve(MakeDoubleEqualityTask({0, 1})).has_value());
+		CHECK_FALSE(solver.TrySolve(MakeDoubleSumTask({0, 1, 2})).has_value());
+		CHECK_FALSE(solver.TrySolve(MakeDoubleEqualityTask({1, 0})).has_value());
+
+		solution = solver.TrySolve(MakeChainTask(1, {1, 0}));
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution->CSMIds, Equals(std::vector<size_t>{2, 1}));
+	}
+
+	SECTION("kept plan gives the same solution as a new one on random edits") {
+		std::mt19937 random(11);
+		const size_t propertiesCount = 8;
+		std::vector<std::vector<size_t>> sums;
+		std::vector<size_t> stayOrder(propertiesCount);
+		std::iota(stayOrder.begin(), stayOrder.end(), 0);
+
+		size_t solvedCount = 0;
+		const size_t iterationsCount = 300;
+		for (size_t iteration = 0; iteration < iterationsCount; ++iteration) {
+			// an edit moves a stay to the front, adds or removes a sum, so the
+			// graph goes back and forth between a forest and one with cycles
+			switch (sums.size() < 3 ? random() % 3 : 2) {
+				case 0: {
+					size_t edited = random() % propertiesCount;
+					std::erase(stayOrder, edited);
+					stayOrder.insert(stayOrder.begin(), edited);
+					break;
+				}
+				case 1: {
+					std::vector<size_t> propertyIds(propertiesCount);
+					std::iota(propertyIds.begin(), propertyIds.end(), 0);
+					std::ranges::shuffle(propertyIds, random);
+					propertyIds.resize(2 + random() % 2);
+					sums.insert(sums.begin() + random() % (sums.size() + 1), std::move(propertyIds));
+					break;
+				}
+				case 2: {
+					if (!sums.empty()) {
+						sums.erase(sums.begin() + random() % sums.size());
+					}
+					break;
+				}
+			}
+
+			TTask task{.PropertiesCount = propertiesCount, .ConstraintsCount = 0, .CSMs{}};
+			for (const auto &propertyIds : sums) {
+				AddSum(task, propertyIds);
+			}
+			for (const auto &propertyId : stayOrder) {
+				task.CSMs.push_back({.ConstraintId = task.ConstraintsCount++, .InputPropertyIds = {}, .OutputPropertyIds = {propertyId}});
+			}
+
+			auto solution = solver.TrySolve(task);
+			auto expected = TSolver{TDeltaBlueSolver{}}.TrySolve(task);
+			REQUIRE(solution.has_value() == expected.has_value());
+			if (solution.has_value()) {
+				++solvedCount;
+				CHECK(IsValidPlan(task, *solution));
+				CHECK_THAT(solution->CSMIds, Equals(expected->CSMIds));
+			}
+		}
+		// both forests and graphs with cycles were met
+		CHECK(solvedCount > iterationsCount / 2);
+		CHECK(solvedCount < iterationsCount);
+	}
+}
+
+}  // namespace
+
+}  // namespace NPropertyModels::NSolver::NTesting
@@ -366,6 +366,42 @@ TEST_CASE("maximum matching implemets try solve right", "[solver][maximum_matchi
 		REQUIRE(solution.has_value());
 		CHECK_THAT(solution.value().CSMIds, Equals(std::vector<size_t>{2, 1, 4, 0, 3}));
 	}
+
+	SECTION("stronger constraints stay enforced") {
+		// 1 and 2 would also be a maximum matching, but 0 is stronger than 2
+		TTask task{
+		    .PropertiesCount = 2,
+		    .ConstraintsCount = 3,
+		    .CSMs{
+		        {
+		            .ConstraintId = 0,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {0},
+		        },
+		        {
+		            .ConstraintId = 0,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {1},
+		        },
+		        {
+		            .ConstraintId = 1,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {0},
+		        },
+		        {
+		            .ConstraintId = 2,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {1},
+		        },
+		    },
+		};
+
+		std::optional<TSolution> solution;
+		REQUIRE_NOTHROW(solution = solver.TrySolve(task));
+
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution.value().CSMIds, UnorderedEquals(std::vector<size_t>{1, 2}));
+	}
 }
 
 }  // namespace
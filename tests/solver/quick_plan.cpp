@@ -1,5 +1,8 @@
 #include "solver/quick_plan.h"
 
+#include <algorithm>
+#include <random>
+
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/generators/catch_generators.hpp"
 #include "catch2/matchers/catch_matchers_vector.hpp"
@@ -10,6 +13,87 @@ namespace {
 
 using namespace Catch::Matchers;
 
+// every property is written at most once and after the properties it is
+// computed from, every constraint has at most one CSM in the plan
+bool IsValidPlan(const TTask &task, const std::vector<size_t> &csmIds) {
+	std::vector<uint8_t> written(task.PropertiesCount, 0);
+	std::vector<uint8_t> planned(task.ConstraintsCount, 0);
+	for (const auto &csmId : csmIds) {
+		const auto &csm = task.CSMs[csmId];
+		if (planned[csm.ConstraintId]++) {
+			return false;
+		}
+		for (const auto &propertyId : csm.OutputPropertyIds) {
+			if (written[propertyId]++) {
+				return false;
+			}
+		}
+	}
+	std::vector<uint8_t> ready(task.PropertiesCount, 0);
+	for (const auto &csmId : csmIds) {
+		const auto &csm = task.CSMs[csmId];
+		for (const auto &propertyId : csm.InputPropertyIds) {
+			if (written[propertyId] && !ready[propertyId]) {
+				return false;
+			}
+		}
+		for (const auto &propertyId : csm.OutputPropertyIds) {
+			ready[propertyId] = 1;
+		}
+	}
+	return true;
+}
+
+// tries every choice of CSMs of the constraints
+bool HasPlan(const TTask &task, const std::vector<size_t> &constraintIds) {
+	std::vector<std::vector<size_t>> csmsByConstraint(task.ConstraintsCount);
+	for (size_t csmId = 0; csmId < task.CSMs.size(); ++csmId) {
+		csmsByConstraint[task.CSMs[csmId].ConstraintId].push_back(csmId);
+	}
+
+	std::vector<size_t> choice(constraintIds.size(), 0);
+	while (true) {
+		std::vector<size_t> csmIds;
+		for (size_t i = 0; i < constraintIds.size(); ++i) {
+			const auto &csmIdsOfConstraint = csmsByConstraint[constraintIds[i]];
+			if (csmIdsOfConstraint.empty()) {
+				return false;
+			}
+			csmIds.push_back(csmIdsOfConstraint[choice[i]]);
+		}
+		std::ranges::sort(csmIds);
+		do {
+			if (IsValidPlan(task, csmIds)) {
+				return true;
+			}
+		} while (std::ranges::next_permutation(csmIds).found);
+
+		size_t i = 0;
+		for (; i < constraintIds.size(); ++i) {
+			if (++choice[i] < csmsByConstraint[constraintIds[i]].size()) {
+				break;
+			}
+			choice[i] = 0;
+		}
+		if (i == constraintIds.size()) {
+			return false;
+		}
+	}
+}
+
+// constraints from the strongest one, each kept if there is a plan with it
+// and the ones kept before
+std::vector<size_t> GetEnforcedConstraints(const TTask &task) {
+	std::vector<size_t> enforced;
+	for (size_t constraintId = 0; constraintId < task.ConstraintsCount; ++constraintId) {
+		enforced.push_back(constraintId);
+		if (!HasPlan(task, enforced)) {
+			enforced.pop_back();
+		}
+	}
+	return enforced;
+}
+
 TEST_CASE("quick plan implemets is applicable right", "[solver][quick_plan][is_applicable]") {
 	TSolver solver{TQuickPlanSolver{}};
 
@@ -340,6 +424,219 @@ TEST_CASE("quick plan implemets try solve right", "[solver][quick_plan][try_solv
 		REQUIRE(solution.has_value());
 		CHECK_THAT(solution.value().CSMIds, Equals(std::vector<size_t>{2, 1, 4, 0, 3}));
 	}
+
+	SECTION("right order after sieving up") {
+		/*
+		   x  x
+		    \/
+		     o--x--o
+		*/
+		// the CSM reading 0 is sieved down first, the stays writing 0 are
+		// left for sieving up and go first in the plan
+		TTask task{
+		    .PropertiesCount = 2,
+		    .ConstraintsCount = 3,
+		    .CSMs{
+		        {
+		            .ConstraintId = 0,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {0},
+		        },
+		        {
+		            .ConstraintId = 1,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {0},
+		        },
+		        {
+		            .ConstraintId = 2,
+		            .InputPropertyIds = {0},
+		            .OutputPropertyIds = {1},
+		        },
+		    },
+		};
+
+		std::optional<TSolution> solution;
+		REQUIRE_NOTHROW(solution = solver.TrySolve(task));
+
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution.value().CSMIds, Equals(std::vector<size_t>{0, 2}));
+	}
+
+	SECTION("failed insertion leaves the plan as it was") {
+		// the stays of 1 and 2 do not fit, the equality after the first one
+		// is still planned
+		TTask task{
+		    .PropertiesCount = 3,
+		    .ConstraintsCount = 5,
+		    .CSMs{
+		        {
+		            .ConstraintId = 0,
+		            .InputPropertyIds = {0},
+		            .OutputPropertyIds = {1},
+		        },
+		        {
+		            .ConstraintId = 0,
+		            .InputPropertyIds = {1},
+		            .OutputPropertyIds = {0},
+		        },
+		        {
+		            .ConstraintId = 1,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {0},
+		        },
+		        {
+		            .ConstraintId = 2,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {1},
+		        },
+		        {
+		            .ConstraintId = 3,
+		            .InputPropertyIds = {1},
+		            .OutputPropertyIds = {2},
+		        },
+		        {
+		            .ConstraintId = 3,
+		            .InputPropertyIds = {2},
+		            .OutputPropertyIds = {1},
+		        },
+		        {
+		            .ConstraintId = 4,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {2},
+		        },
+		    },
+		};
+
+		std::optional<TSolution> solution;
+		REQUIRE_NOTHROW(solution = solver.TrySolve(task));
+
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution.value().CSMIds, Equals(std::vector<size_t>{2, 0, 4}));
+	}
+
+	SECTION("multi-output CSMs are retracted") {
+		// the stays of 1 and 2 take both outputs of the first CSM, so the
+		// second one is chosen and the stay of 0 does not fit
+		TTask task{
+		    .PropertiesCount = 3,
+		    .ConstraintsCount = 4,
+		    .CSMs{
+		        {
+		            .ConstraintId = 0,
+		            .InputPropertyIds = {0},
+		            .OutputPropertyIds = {1, 2},
+		        },
+		        {
+		            .ConstraintId = 0,
+		            .InputPropertyIds = {1, 2},
+		            .OutputPropertyIds = {0},
+		        },
+		        {
+		            .ConstraintId = 1,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {1},
+		        },
+		        {
+		            .ConstraintId = 2,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {2},
+		        },
+		        {
+		            .ConstraintId = 3,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {0},
+		        },
+		    },
+		};
+
+		std::optional<TSolution> solution;
+		REQUIRE_NOTHROW(solution = solver.TrySolve(task));
+
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution.value().CSMIds, UnorderedEquals(std::vector<size_t>{1, 2, 3}));
+		CHECK(solution.value().CSMIds.back() == 1);
+	}
+
+	SECTION("weaker constraints give way") {
+		// the stronger stay is listed last
+		TTask task{
+		    .PropertiesCount = 2,
+		    .ConstraintsCount = 3,
+		    .CSMs{
+		        {
+		            .ConstraintId = 2,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {0},
+		        },
+		        {
+		            .ConstraintId = 0,
+		            .InputPropertyIds = {0},
+		            .OutputPropertyIds = {1},
+		        },
+		        {
+		            .ConstraintId = 0,
+		            .InputPropertyIds = {1},
+		            .OutputPropertyIds = {0},
+		        },
+		        {
+		            .ConstraintId = 1,
+		            .InputPropertyIds = {},
+		            .OutputPropertyIds = {1},
+		        },
+		    },
+		};
+
+		std::optional<TSolution> solution;
+		REQUIRE_NOTHROW(solution = solver.TrySolve(task));
+
+		REQUIRE(solution.has_value());
+		CHECK_THAT(solution.value().CSMIds, Equals(std::vector<size_t>{3, 2}));
+	}
+
+	SECTION("random tasks") {
+		std::mt19937 random(5);
+		for (size_t iteration = 0; iteration < 300; ++iteration) {
+			// constraints over up to three random properties, every CSM
+			// writes one or two of them and reads the rest
+			const size_t propertiesCount = 2 + random() % 4;
+			TTask task{
+			    .PropertiesCount = propertiesCount,
+			    .ConstraintsCount = 1 + random() % 6,
+			    .CSMs{},
+			};
+			for (size_t constraintId = 0; constraintId < task.ConstraintsCount; ++constraintId) {
+				std::vector<size_t> domain(propertiesCount);
+				for (size_t id = 0; id < propertiesCount; ++id) {
+					domain[id] = id;
+				}
+				std::ranges::shuffle(domain, random);
+				domain.resize(1 + random() % std::min<size_t>(propertiesCount, 3));
+
+				for (size_t csmsCount = 1 + random() % 3; csmsCount > 0; --csmsCount) {
+					std::ranges::shuffle(domain, random);
+					const size_t outputsCount = 1 + random() % std::min<size_t>(domain.size(), 2);
+					task.CSMs.push_back({
+					    .ConstraintId = constraintId,
+					    .InputPropertyIds = {domain.begin() + outputsCount, domain.end()},
+					    .OutputPropertyIds = {domain.begin(), domain.begin() + outputsCount},
+					});
+				}
+			}
+
+			std::optional<TSolution> solution;
+			REQUIRE_NOTHROW(solution = solver.TrySolve(task));
+
+			REQUIRE(solution.has_value());
+			CHECK(IsValidPlan(task, solution.value().CSMIds));
+
+			std::vector<size_t> enforced;
+			for (const auto &csmId : solution.value().CSMIds) {
+				enforced.push_back(task.CSMs[csmId].ConstraintId);
+			}
+			std::ranges::sort(enforced);
+			CHECK_THAT(enforced, Equals(GetEnforcedConstraints(task)));
+		}
+	}
 }
 
 }  // namespace